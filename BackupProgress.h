@@ -0,0 +1,54 @@
+#pragma once
+#include <QAtomicInteger>
+#include <QtGlobal>
+
+/**
+ * @brief 备份任务的进度通道：复制通道逐文件只做原子累加，界面/命令行按自己的定时器取快照
+ * 不再为每个文件跨线程投递 fileStarted/fileFinished（各带 QString 拷贝、在 GUI 线程各执行一次 lambda）。
+ * 由 BackupWorker 创建，以 shared_ptr 交给观察方：worker 先被 deleteLater 也不影响读取。
+ * 失败项与留存事件仍逐个以信号送达（需要明细）。
+ */
+class BackupProgress {
+public:
+    struct Snapshot {
+        qint64 bytesDone   = 0;
+        qint64 bytesTotal  = 0;                              // 扫描期间仍在增长
+        qint64 filesTotal  = 0;                              // 已扫描到的文件数
+        qint64 filesDone   = 0;                              // 已处理（复制/跳过/失败）
+        qint64 filesCopied = 0;
+        qint64 filesFailed = 0;
+        double bytesPerSec = 0.0;
+        qint64 etaSec      = -1;
+    };
+
+    // 写端（worker 的扫描线程/复制通道/run() 汇总）
+    QAtomicInteger<qint64> bytesDone{0};
+    QAtomicInteger<qint64> bytesTotal{0};
+    QAtomicInteger<qint64> filesTotal{0};
+    QAtomicInteger<qint64> filesDone{0};
+    QAtomicInteger<qint64> filesCopied{0};
+    QAtomicInteger<qint64> filesFailed{0};
+    QAtomicInteger<qint64> bytesPerSec{0};                  // run() 每 200ms 汇总一次
+    QAtomicInteger<qint64> etaSec{-1};
+
+    void reset() {
+        for (QAtomicInteger<qint64>* c : {&bytesDone, &bytesTotal, &filesTotal, &filesDone,
+                                          &filesCopied, &filesFailed, &bytesPerSec})
+            c->storeRelaxed(0);
+        etaSec.storeRelaxed(-1);
+    }
+
+    // 读端：各字段分别读取，彼此间可能差一两个文件，显示用足够
+    Snapshot snapshot() const {
+        Snapshot s;
+        s.bytesDone   = bytesDone.loadRelaxed();
+        s.bytesTotal  = bytesTotal.loadRelaxed();
+        s.filesTotal  = filesTotal.loadRelaxed();
+        s.filesDone   = filesDone.loadRelaxed();
+        s.filesCopied = filesCopied.loadRelaxed();
+        s.filesFailed = filesFailed.loadRelaxed();
+        s.bytesPerSec = double(bytesPerSec.loadRelaxed());
+        s.etaSec      = etaSec.loadRelaxed();
+        return s;
+    }
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <functional>
+#include <utility>
+
+/**
+ * @brief 有界阻塞队列（单/多生产者 → 多消费者）
+ * 队列满时生产者等待，队列空时消费者等待；生产者 close() 后消费者取完剩余即结束。
+ * 等待按 50ms 切片进行，期间检查 cancelled()，保证停止请求能及时生效。
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(int capacity) : m_capacity(qMax(1, capacity)) {}
+
+    // 放入一项；队列已关闭或 cancelled() 为真返回 false
+    bool push(T v, const std::function<bool()>& cancelled = {}) {
+        QMutexLocker lk(&m_mutex);
+        while (m_queue.size() >= m_capacity && !m_closed) {
+            if (cancelled && cancelled()) return false;
+            m_notFull.wait(&m_mutex, 50);
+        }
+        if (m_closed) return false;
+        m_queue.enqueue(std::move(v));
+        m_notEmpty.wakeOne();
+        return true;
+    }
+
+    // 取出一项；队列已关闭且取空、或 cancelled() 为真返回 false
+    bool pop(T* out, const std::function<bool()>& cancelled = {}) {
+        QMutexLocker lk(&m_mutex);
+        while (m_queue.isEmpty() && !m_closed) {
+            if (cancelled && cancelled()) return false;
+            m_notEmpty.wait(&m_mutex, 50);
+        }
+        if (m_queue.isEmpty()) return false;
+        *out = m_queue.dequeue();
+        m_notFull.wakeOne();
+        return true;
+    }
+
+    // 生产结束：唤醒所有等待方
+    void close() {
+        QMutexLocker lk(&m_mutex);
+        m_closed = true;
+        m_notEmpty.wakeAll();
+        m_notFull.wakeAll();
+    }
+
+private:
+    const int      m_capacity;
+    QMutex         m_mutex;
+    QWaitCondition m_notEmpty, m_notFull;
+    QQueue<T>      m_queue;
+    bool           m_closed = false;
+};
@@ -0,0 +1,97 @@
+#pragma once
+#include <QMutex>
+#include <QVector>
+#include <QtGlobal>
+#include <new>
+#include <utility>
+
+/**
+ * @brief 复制/哈希用的 I/O 缓冲池（按 2 的幂分档，64KB..8MB，按页对齐）
+ * - pickSize：按文件大小与实测吞吐选缓冲：小文件不再白分配 1MB；快设备上的大文件用更大的缓冲减少系统调用
+ * - acquire 返回 Lease，析构时归还；池内闲置总量有上限，超出直接释放
+ * 线程安全：同一任务的多个复制通道/读线程共用一个池。
+ */
+class BufferPool {
+public:
+    static constexpr qint64 kMinBuf   = 64 * 1024;
+    static constexpr qint64 kMaxBuf   = 8 * 1024 * 1024;
+    static constexpr qint64 kAlign    = 4096;
+    static constexpr int    kClasses  = 8;                   // 64K,128K,...,8M
+
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(Lease&& o) noexcept { swap(o); }
+        Lease& operator=(Lease&& o) noexcept { if (this != &o) { release(); swap(o); } return *this; }
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease() { release(); }
+
+        char*  data() const { return m_data; }
+        qint64 size() const { return m_size; }
+
+    private:
+        friend class BufferPool;
+        Lease(BufferPool* pool, char* data, qint64 size) : m_pool(pool), m_data(data), m_size(size) {}
+        void swap(Lease& o) { std::swap(m_pool, o.m_pool); std::swap(m_data, o.m_data); std::swap(m_size, o.m_size); }
+        void release() { if (m_data) m_pool->giveBack(m_data, m_size); m_data = nullptr; m_size = 0; }
+
+        BufferPool* m_pool = nullptr;
+        char*       m_data = nullptr;
+        qint64      m_size = 0;
+    };
+
+    explicit BufferPool(qint64 maxIdleBytes = 64LL * 1024 * 1024) : m_maxIdle(maxIdleBytes) {}
+    ~BufferPool() {
+        for (auto& list : m_free)
+            for (char* p : list) ::operator delete(p, std::align_val_t(kAlign));
+    }
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // 一次 I/O 约搬运 25ms 的数据（吞吐未知时 1MB），且不超过文件本身
+    static qint64 pickSize(qint64 fileSize, double bytesPerSec) {
+        qint64 want = bytesPerSec > 0 ? qint64(bytesPerSec * 0.025) : qint64(1) << 20;
+        want = qBound<qint64>(256 * 1024, want, kMaxBuf);
+        if (fileSize >= 0) want = qMin(want, fileSize);
+        return classSize(classOf(want));
+    }
+
+    Lease acquire(qint64 size) {
+        const int c = classOf(size);
+        const qint64 bytes = classSize(c);
+        {
+            QMutexLocker lk(&m_mutex);
+            if (!m_free[c].isEmpty()) {
+                m_idle -= bytes;
+                return Lease(this, m_free[c].takeLast(), bytes);
+            }
+        }
+        return Lease(this, static_cast<char*>(::operator new(size_t(bytes), std::align_val_t(kAlign))), bytes);
+    }
+
+private:
+    static int classOf(qint64 size) {
+        int c = 0;
+        while (c < kClasses - 1 && classSize(c) < size) ++c;
+        return c;
+    }
+    static qint64 classSize(int c) { return kMinBuf << c; }
+
+    void giveBack(char* p, qint64 bytes) {
+        {
+            QMutexLocker lk(&m_mutex);
+            if (m_idle + bytes <= m_maxIdle) {
+                m_free[classOf(bytes)].append(p);
+                m_idle += bytes;
+                return;
+            }
+        }
+        ::operator delete(p, std::align_val_t(kAlign));
+    }
+
+    QMutex          m_mutex;
+    QVector<char*>  m_free[kClasses];
+    qint64          m_idle = 0;
+    const qint64    m_maxIdle;
+};
@@ -0,0 +1,93 @@
+#pragma once
+#include <QHash>
+#include <QMutex>
+#include <QQueue>
+#include <QString>
+#include <memory>
+
+#include "FileStat.h"
+#include "treewalker.h"
+
+/**
+ * @brief 目标侧元数据快照（按目录成批取得，多个复制通道共用）
+ * - 同一目录的查询达到 kBulkAfter 次后，整层列举一次（TreeWalker 单层：getdents64 + 每项一次 fstatat），
+ *   之后同目录的文件直接查表；零散改动的大目录仍逐个 stat，不会为一两个文件列举整个目录
+ * - 目录本身不存在也记下来：首轮备份到空目标时，同目录的其余文件不再 stat
+ * - take() 取走即删除：每个文件一轮只查一次，之后由复制通道自己改写目标，快照不必维护
+ * 最多同时缓存 kMaxDirs 个目录，超出按进入顺序淘汰。
+ */
+class DirStatCache {
+public:
+    static constexpr int kBulkAfter = 4;
+    static constexpr int kMaxDirs   = 64;
+
+    explicit DirStatCache(QString root = QString()) : m_root(std::move(root)) {}
+
+    // rel：相对 root 的文件路径（'/' 分隔）
+    FileStat take(const QString& rel) {
+        const int slash = rel.lastIndexOf(QChar('/'));
+        const QString dir  = slash < 0 ? QString() : rel.left(slash);
+        const QString name = rel.mid(slash + 1);
+
+        std::shared_ptr<Dir> d;
+        {
+            QMutexLocker lk(&m_mutex);
+            d = dirFor(dir);
+            if (d->missing) return FileStat();
+            if (d->listed) return d->files.take(name);
+            const int queries = ++d->queries;
+            if (queries < kBulkAfter) {
+                lk.unlock();
+                return probe(d, dir, rel, queries == 1);
+            }
+        }
+
+        // 列举在锁外做；两个通道同时列举同一目录只是多做一遍
+        QHash<QString, FileStat> files;
+        TreeWalker::Options wo;
+        wo.recursive     = false;
+        wo.includeHidden = true;
+        wo.threads       = 1;
+        TreeWalker::walk(absDir(dir), wo, [&](TreeWalker::Entry& e) { files.insert(e.rel, e.st); return true; });
+
+        QMutexLocker lk(&m_mutex);
+        if (!d->listed) { d->files = std::move(files); d->listed = true; }
+        return d->files.take(name);
+    }
+
+private:
+    struct Dir {
+        int  queries = 0;
+        bool listed  = false;
+        bool missing = false;
+        QHash<QString, FileStat> files;
+    };
+
+    QString absDir(const QString& dir) const { return dir.isEmpty() ? m_root : m_root + QChar('/') + dir; }
+
+    // 调用方持锁
+    std::shared_ptr<Dir> dirFor(const QString& dir) {
+        auto it = m_dirs.find(dir);
+        if (it != m_dirs.end()) return it.value();
+        while (m_order.size() >= kMaxDirs) m_dirs.remove(m_order.dequeue());
+        auto d = std::make_shared<Dir>();
+        m_dirs.insert(dir, d);
+        m_order.enqueue(dir);
+        return d;
+    }
+
+    // 逐个 stat；该目录第一次查询且文件不存在时顺带确认目录是否存在
+    FileStat probe(const std::shared_ptr<Dir>& d, const QString& dir, const QString& rel, bool first) {
+        const FileStat st = statPath(m_root + QChar('/') + rel);
+        if (!st.exists && first && !statPath(absDir(dir)).exists) {
+            QMutexLocker lk(&m_mutex);
+            d->missing = true;
+        }
+        return st;
+    }
+
+    QString m_root;
+    QMutex  m_mutex;
+    QHash<QString, std::shared_ptr<Dir>> m_dirs;
+    QQueue<QString> m_order;
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <QDir>
+#include <QFileInfo>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @brief 文件监听得到的“脏路径”日志：下一轮只扫描这些目录（增量运行）
+ * - markDir：目录内条目有变化，只重扫这一层（文件增删改、子目录被删/改名）
+ * - markTree：新出现的目录，整棵扫描（监听注册前写入的文件也要覆盖）
+ * - markLost：事件可能丢失（监听重建、上一轮失败、条目过多）→ 下一轮必须全量
+ * 初始即为“丢失”：启动前发生的改动无从得知，首轮总是全量。
+ * 只在 GUI/守护进程线程使用，不加锁。
+ */
+class DirtyJournal {
+public:
+    static constexpr int kMaxEntries = 20000; // 超过后增量不再划算，直接退化为全量
+
+    void markDir(const QString& absDir)   { add(&m_dirs, absDir); }
+    void markTree(const QString& absDir)  { add(&m_trees, absDir); }
+    void markFile(const QString& absFile) { add(&m_dirs, QFileInfo(absFile).absolutePath()); }
+    void markLost()                       { m_lost = true; m_dirs.clear(); m_trees.clear(); }
+
+    bool needsFullScan() const { return m_lost; }
+    bool isEmpty() const       { return m_dirs.isEmpty() && m_trees.isEmpty(); }
+
+    // 一轮开始时调用：之后的事件记入新日志
+    void reset() { m_lost = false; m_dirs.clear(); m_trees.clear(); }
+
+    // root 下的脏目录（相对 root，"" = 根目录本层）；root 下无改动返回 false
+    bool scopeFor(const QString& root, QStringList* dirs, QStringList* trees) const {
+        const QString r = QDir::cleanPath(QDir(root).absolutePath());
+        const int before = dirs->size() + trees->size();
+        collect(m_dirs,  r, dirs);
+        collect(m_trees, r, trees);
+        return dirs->size() + trees->size() > before;
+    }
+
+private:
+    void add(QSet<QString>* set, const QString& path) {
+        if (m_lost) return;
+        if (m_dirs.size() + m_trees.size() >= kMaxEntries) { markLost(); return; }
+        set->insert(QDir::cleanPath(QDir(path).absolutePath()));
+    }
+
+    static void collect(const QSet<QString>& set, const QString& root, QStringList* out) {
+        const QString prefix = root.endsWith('/') ? root : root + '/';
+        for (const QString& p : set) {
+            if (p == root)                   out->append(QString());
+            else if (p.startsWith(prefix))   out->append(p.mid(prefix.size()));
+        }
+    }
+
+    QSet<QString> m_dirs;
+    QSet<QString> m_trees;
+    bool          m_lost = true;
+};
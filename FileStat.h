@@ -0,0 +1,47 @@
+#pragma once
+#include <QString>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+
+#ifdef Q_OS_UNIX
+#  include <sys/stat.h>
+#endif
+
+/**
+ * @brief 一次 stat 得到的文件元数据
+ * fileId：Unix 为 inode；其它平台取不到时为 0（比较时忽略）
+ */
+struct FileStat {
+    bool    exists  = false;
+    bool    isFile  = false;
+    qint64  size    = 0;
+    qint64  mtimeMs = 0;
+    quint64 fileId  = 0;
+};
+
+// 只做一次系统调用（Unix: stat；其它平台退回 QFileInfo）
+inline FileStat statPath(const QString& path) {
+    FileStat r;
+#ifdef Q_OS_UNIX
+    struct stat st;
+    if (::stat(QFile::encodeName(path).constData(), &st) != 0) return r;
+    r.exists = true;
+    r.isFile = S_ISREG(st.st_mode);
+    r.size   = qint64(st.st_size);
+#  if defined(Q_OS_DARWIN)
+    r.mtimeMs = qint64(st.st_mtimespec.tv_sec) * 1000 + st.st_mtimespec.tv_nsec / 1000000;
+#  else
+    r.mtimeMs = qint64(st.st_mtim.tv_sec) * 1000 + st.st_mtim.tv_nsec / 1000000;
+#  endif
+    r.fileId = quint64(st.st_ino);
+#else
+    QFileInfo fi(path);
+    if (!fi.exists()) return r;
+    r.exists  = true;
+    r.isFile  = fi.isFile();
+    r.size    = fi.size();
+    r.mtimeMs = fi.lastModified().toMSecsSinceEpoch();
+#endif
+    return r;
+}
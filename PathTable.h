@@ -0,0 +1,148 @@
+#pragma once
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+#include <cstring>
+#include <vector>
+
+/**
+ * @brief 紧凑的相对路径集合（一轮备份的源文件表；替代 QSet<QString>）
+ * - 目录前缀只存一次：每个目录是（父目录, 名字）节点，文件是（所在目录, 名字）节点
+ * - 名字以 UTF-8 连续存放在一块 arena 里，节点只记偏移/长度，没有逐项的 QString 与哈希节点
+ * - 成员判断走开放寻址哈希表（线性探测，负载 ≤ 1/2），槽里只放 32 位哈希与节点下标
+ * 300 万文件约占 100MB 量级（QSet<QString> 同等规模超过 1GB）。
+ * 非线程安全：扫描线程写入，扫描结束后其他线程只读。
+ */
+class PathTable {
+public:
+    using Id = quint32;
+    static constexpr Id kNone = 0xffffffffu;
+
+    PathTable() { clear(); }
+
+    void clear() {
+        m_arena.clear();
+        m_dirs.assign(1, Node{kNone, 0, 0});                 // 0 号目录 = 根
+        m_files.clear();
+        m_dirSlots.assign(64, Slot{});
+        m_fileSlots.assign(64, Slot{});
+    }
+
+    void reserve(int files) {
+        m_files.reserve(size_t(files));
+        m_arena.reserve(size_t(files) * 16);
+        grow(m_fileSlots, size_t(files) * 2);
+    }
+
+    int  size() const    { return int(m_files.size()); }
+    bool isEmpty() const { return m_files.empty(); }
+
+    // 加入相对路径（'/' 分隔、已规范化）；已存在返回 false
+    bool insert(const QString& rel, Id* idOut = nullptr) {
+        const QByteArray u = rel.toUtf8();
+        const char* p = u.constData();
+        const char* end = p + u.size();
+        Id dir = 0;
+        for (const char* slash; (slash = nextSlash(p, end)) != end; p = slash + 1)
+            dir = intern(m_dirs, m_dirSlots, dir, p, int(slash - p));
+        const quint32 before = quint32(m_files.size());
+        const Id id = intern(m_files, m_fileSlots, dir, p, int(end - p));
+        if (idOut) *idOut = id;
+        return id == before;
+    }
+
+    Id find(const QString& rel) const {
+        const QByteArray u = rel.toUtf8();
+        const char* p = u.constData();
+        const char* end = p + u.size();
+        Id dir = 0;
+        for (const char* slash; (slash = nextSlash(p, end)) != end; p = slash + 1)
+            if ((dir = lookup(m_dirs, m_dirSlots, dir, p, int(slash - p))) == kNone) return kNone;
+        return lookup(m_files, m_fileSlots, dir, p, int(end - p));
+    }
+
+    bool contains(const QString& rel) const { return find(rel) != kNone; }
+
+    // 由节点还原相对路径（只在需要时拼接）
+    QString path(Id id) const {
+        const Node& f = m_files[id];
+        std::vector<const Node*> chain{&f};
+        for (Id d = f.parent; d != 0; d = m_dirs[d].parent) chain.push_back(&m_dirs[d]);
+        QByteArray out;
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+            if (!out.isEmpty()) out.append('/');
+            out.append(m_arena.data() + (*it)->nameOff, int((*it)->nameLen));
+        }
+        return QString::fromUtf8(out);
+    }
+
+private:
+    struct Node { Id parent; quint32 nameOff; quint32 nameLen; };
+    struct Slot { quint32 hash = 0; Id idx = kNone; };
+
+    static const char* nextSlash(const char* p, const char* end) {
+        while (p != end && *p != '/') ++p;
+        return p;
+    }
+
+    // FNV-1a，父节点下标参与种子：不同目录下的同名项落在不同槽
+    static quint32 hashOf(Id parent, const char* name, int len) {
+        quint32 h = 2166136261u ^ (parent * 0x9e3779b9u);
+        for (int i = 0; i < len; ++i) { h ^= quint8(name[i]); h *= 16777619u; }
+        return h;
+    }
+
+    bool same(const Node& n, Id parent, const char* name, int len) const {
+        return n.parent == parent && int(n.nameLen) == len
+            && (len == 0 || memcmp(m_arena.data() + n.nameOff, name, size_t(len)) == 0);
+    }
+
+    Id lookup(const std::vector<Node>& nodes, const std::vector<Slot>& table,
+              Id parent, const char* name, int len) const {
+        const quint32 h = hashOf(parent, name, len);
+        const size_t mask = table.size() - 1;
+        for (size_t i = h & mask; table[i].idx != kNone; i = (i + 1) & mask)
+            if (table[i].hash == h && same(nodes[table[i].idx], parent, name, len)) return table[i].idx;
+        return kNone;
+    }
+
+    Id intern(std::vector<Node>& nodes, std::vector<Slot>& table, Id parent, const char* name, int len) {
+        const quint32 h = hashOf(parent, name, len);
+        size_t mask = table.size() - 1;
+        size_t i = h & mask;
+        for (; table[i].idx != kNone; i = (i + 1) & mask)
+            if (table[i].hash == h && same(nodes[table[i].idx], parent, name, len)) return table[i].idx;
+
+        const Id id = Id(nodes.size());
+        nodes.push_back(Node{parent, quint32(m_arena.size()), quint32(len)});
+        m_arena.insert(m_arena.end(), name, name + len);
+        if (nodes.size() * 2 > table.size()) {
+            grow(table, table.size() * 2);            // 扩容后重新定位，再放入
+            mask = table.size() - 1;
+            for (i = h & mask; table[i].idx != kNone; i = (i + 1) & mask) {}
+        }
+        table[i] = Slot{h, id};
+        return id;
+    }
+
+    // 扩到不小于 want 的 2 的幂并重排已有节点（槽里带哈希，无需重新计算）
+    static void grow(std::vector<Slot>& table, size_t want) {
+        size_t n = table.size();
+        while (n < want) n *= 2;
+        if (n == table.size()) return;
+        std::vector<Slot> next(n);
+        const size_t mask = n - 1;
+        for (const Slot& s : table) {
+            if (s.idx == kNone) continue;
+            size_t i = s.hash & mask;
+            while (next[i].idx != kNone) i = (i + 1) & mask;
+            next[i] = s;
+        }
+        table.swap(next);
+    }
+
+    std::vector<char> m_arena;                               // 所有目录名/文件名（UTF-8，无分隔符）
+    std::vector<Node> m_dirs;                                // 目录节点（0 = 根）
+    std::vector<Node> m_files;                               // 文件节点
+    std::vector<Slot> m_dirSlots, m_fileSlots;
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include <QMutex>
+#include <QThread>
+#include <QElapsedTimer>
+#include <functional>
+
+/**
+ * @brief 多线程共享的限速器（按字节记账）
+ * 所有复制通道共用同一份 B/s 预算：允许提前“透支”一个窗口，超出部分睡眠补齐，
+ * 长期平均速率不超过 bytesPerSec。bytesPerSec <= 0 表示不限速。
+ */
+class RateLimiter {
+public:
+    explicit RateLimiter(qint64 bytesPerSec = 0, int windowMs = 100)
+        : m_bps(bytesPerSec), m_windowMs(windowMs) { m_timer.start(); }
+
+    // 记账 n 字节；需要等待时按 50ms 切片睡眠，cancelled() 为真立即返回
+    void consume(qint64 n, const std::function<bool()>& cancelled = {}) {
+        if (m_bps <= 0 || n <= 0) return;
+        qint64 waitMs = 0;
+        {
+            QMutexLocker lk(&m_mutex);
+            const double now = double(m_timer.elapsed());
+            if (m_busyUntilMs < now) m_busyUntilMs = now;
+            m_busyUntilMs += double(n) * 1000.0 / double(m_bps);
+            waitMs = qint64(m_busyUntilMs - now) - m_windowMs;
+        }
+        while (waitMs > 0) {
+            if (cancelled && cancelled()) return;
+            const qint64 slice = qMin<qint64>(waitMs, 50);
+            QThread::msleep(static_cast<unsigned long>(slice));
+            waitMs -= slice;
+        }
+    }
+
+private:
+    const qint64  m_bps;
+    const int     m_windowMs;
+    QMutex        m_mutex;
+    QElapsedTimer m_timer;
+    double        m_busyUntilMs = 0.0; // 已分配预算用到的时间点
+};
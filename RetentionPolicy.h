@@ -0,0 +1,85 @@
+#pragma once
+#include <QtGlobal>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+/**
+ * @brief 留存策略：对留存区目录里的项（同一文件的多个版本为一组）判定哪些到期
+ * 一项只要被任一保留规则选中就留下：
+ * - 天数窗口：days > 0 时，归档不早于 days 天前（days ≤ 0 且未开启稀疏时不限时间，全部选中）
+ * - 稀疏（keepHourly/keepDaily/keepWeekly 任一 > 0）：是某一档里“最近 N 个有版本的时段”中该时段最新的一项；
+ *   每组最新一项总是选中（时段按 UTC 划分，周从周四 0 点起算）。超出天数窗口的旧版本靠它按档留存
+ * 选中之后 keepVersions > 0 再作上限：只留本组最新的 keepVersions 个。
+ * 稀疏与上限只取决于项本身，与当前时间无关；随时间变化的只有天数窗口，
+ * 因此目录没有变化时，下一次有项到期的时刻可以预先算出（nextExpiryMs）。
+ */
+struct RetentionPolicy {
+    int days         = 7;
+    int keepVersions = 0;
+    int keepHourly   = 0;
+    int keepDaily    = 0;
+    int keepWeekly   = 0;
+
+    struct Item {
+        quint32 group;                                      // 同一文件（同种类、同相对路径）
+        qint64  tsMs;
+    };
+
+    bool thinning() const { return keepHourly > 0 || keepDaily > 0 || keepWeekly > 0; }
+    bool isNoop() const   { return days <= 0 && keepVersions <= 0 && !thinning(); }
+
+    // 到期项在 items 中的下标；*nextExpiryMs：只靠天数窗口留下的项里最早到期的时刻（没有则为 qint64 最大值）
+    std::vector<quint32> expired(const std::vector<Item>& items, qint64 nowMs, qint64* nextExpiryMs = nullptr) const {
+        static constexpr qint64 kHourMs = 3600 * 1000;
+        static constexpr qint64 kDayMs  = 24 * kHourMs;
+        struct Tier { qint64 lenMs; int keep; };
+        const Tier tiers[3] = {{kHourMs, keepHourly}, {kDayMs, keepDaily}, {7 * kDayMs, keepWeekly}};
+
+        std::vector<quint32> order(items.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = quint32(i);
+        std::sort(order.begin(), order.end(), [&](quint32 a, quint32 b) {
+            if (items[a].group != items[b].group) return items[a].group < items[b].group;
+            return items[a].tsMs > items[b].tsMs;          // 组内新 → 旧
+        });
+
+        const qint64 ageCutoff = days > 0 ? nowMs - qint64(days) * kDayMs : std::numeric_limits<qint64>::min();
+        const bool   ageRule   = days > 0 || !thinning();     // 不限天数又开了稀疏：只按档留存
+        qint64 next = std::numeric_limits<qint64>::max();
+        std::vector<quint32> out;
+
+        for (size_t begin = 0; begin < order.size(); ) {
+            size_t end = begin;
+            while (end < order.size() && items[order[end]].group == items[order[begin]].group) ++end;
+
+            qint64 lastBucket[3] = {0, 0, 0};
+            int    buckets[3]    = {0, 0, 0};
+            for (size_t k = begin; k < end; ++k) {
+                const Item& it = items[order[k]];
+                const int rank = int(k - begin);
+
+                // 稀疏：每档里时段变了就是该时段最新的一项
+                bool thinned = thinning() && rank == 0;
+                for (int t = 0; t < 3; ++t) {
+                    if (tiers[t].keep <= 0) continue;
+                    const qint64 b = floorDiv(it.tsMs, tiers[t].lenMs);
+                    if (buckets[t] == 0 || b != lastBucket[t]) {
+                        lastBucket[t] = b;
+                        if (++buckets[t] <= tiers[t].keep) thinned = true;
+                    }
+                }
+
+                const bool inWindow = ageRule && it.tsMs >= ageCutoff;
+                const bool keep = (inWindow || thinned) && (keepVersions <= 0 || rank < keepVersions);
+                if (!keep) { out.push_back(order[k]); continue; }
+                if (days > 0 && !thinned) next = std::min(next, it.tsMs + qint64(days) * kDayMs);
+            }
+            begin = end;
+        }
+        if (nextExpiryMs) *nextExpiryMs = next;
+        return out;
+    }
+
+private:
+    static qint64 floorDiv(qint64 a, qint64 b) { return a >= 0 ? a / b : -((-a + b - 1) / b); }
+};
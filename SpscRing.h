@@ -0,0 +1,67 @@
+#pragma once
+#include <QAtomicInteger>
+#include <QThread>
+#include <QVector>
+#include <functional>
+#include <utility>
+
+/**
+ * @brief 单生产者 → 单消费者的无锁环形队列（容量取 2 的幂）
+ * 头尾各由一方独占写入，只靠 acquire/release 配对，不加锁。
+ * push/pop 在满/空时先让出 CPU，再以 200µs 小睡退避，期间检查 cancelled()。
+ * 用于复制时读线程与写线程之间传递缓冲编号，每项对应 MB 级 I/O，退避开销可忽略。
+ */
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(int capacity) {
+        int cap = 2;
+        while (cap < capacity) cap <<= 1;
+        m_items.resize(cap);
+        m_mask = quint32(cap - 1);
+    }
+
+    bool tryPush(T v) {
+        const quint32 tail = m_tail.loadRelaxed();
+        if (tail - m_head.loadAcquire() > m_mask) return false; // 满
+        m_items[int(tail & m_mask)] = std::move(v);
+        m_tail.storeRelease(tail + 1);
+        return true;
+    }
+
+    bool tryPop(T* out) {
+        const quint32 head = m_head.loadRelaxed();
+        if (head == m_tail.loadAcquire()) return false;         // 空
+        *out = std::move(m_items[int(head & m_mask)]);
+        m_head.storeRelease(head + 1);
+        return true;
+    }
+
+    // 阻塞版本：cancelled() 为真返回 false
+    bool push(T v, const std::function<bool()>& cancelled) {
+        for (int spins = 0; !tryPush(v); ++spins) {
+            if (cancelled()) return false;
+            backoff(spins);
+        }
+        return true;
+    }
+
+    bool pop(T* out, const std::function<bool()>& cancelled) {
+        for (int spins = 0; !tryPop(out); ++spins) {
+            if (cancelled()) return false;
+            backoff(spins);
+        }
+        return true;
+    }
+
+private:
+    static void backoff(int spins) {
+        if (spins < 64) QThread::yieldCurrentThread();
+        else            QThread::usleep(200);
+    }
+
+    QVector<T> m_items;
+    quint32    m_mask = 0;
+    alignas(64) QAtomicInteger<quint32> m_head{0};  // 消费者写
+    alignas(64) QAtomicInteger<quint32> m_tail{0};  // 生产者写
+};
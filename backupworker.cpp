@@ -1,5 +1,9 @@
-#include "BackupWorker.h"
+#include "backupworker.h"
 #include "SpeedAverager.h"
+#include "BoundedQueue.h"
+#include "iouring.h"
+#include "SpscRing.h"
+#include "treewalker.h"
 
 #include <QDirIterator>
 #include <QDir>
@@ -11,14 +15,47 @@
 #include <QDateTime>
 #include <QJsonDocument>
 #include <QJsonObject>
-#include <QSet>
-#include <QStorageInfo>
+#include <QSaveFile>
 
+#include <algorithm>
+#include <limits>
 #include <utility>
 #include <cmath>
 
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
 BackupWorker::BackupWorker(Options opt, QObject* parent)
-    : QObject(parent), m_opt(std::move(opt)) {}
+    : QObject(parent), m_opt(std::move(opt)), m_limiter(m_opt.speedLimitBps), m_device(m_opt.dstDir) {
+    m_opt.hashAlgo = Digest::effective(m_opt.hashAlgo); // 未编译进来的算法退回 SHA-256，元数据记录实际所用
+    // 两个根只规范化一次，逐文件只做字符串拼接
+    m_srcRootAbs = QDir(m_opt.srcDir).absolutePath();
+    m_nsRootAbs  = QDir(m_opt.dstDir).absoluteFilePath(nsPrefix());
+    m_catalog.reset(new VaultCatalog(metaRoot(), nsPrefix()));
+}
+
+// 扫描 → 复制之间的队列容量：扫描领先复制太多只会徒增内存
+static const int kScanQueueCapacity = 4096;
+
+// 小于该大小的文件整文件复制更划算（签名/比对开销不值得）
+static const qint64 kDeltaMinSize = 16LL * 1024 * 1024;
+
+// 删除保护：一轮里源中不见的文件不少于该数、且超过已备份文件的一半 → 暂缓移走，等确认
+static const int kMassDeletionMinFiles = 200;
+
+// io_uring：小文件建 ring/注册缓冲的开销不划算；8 个槽同时在途（槽大小见 ioBufSize）
+static const qint64 kUringMinSize = 8LL * 1024 * 1024;
+static const int    kUringSlots   = 8;
+static const qint64 kUringSlotMax = 2LL * 1024 * 1024;   // 槽数已摊薄系统调用，单槽再大只会多占内存
+
+// 读写线程流水线：小文件起线程不划算；4 个缓冲（大小见 ioBufSize）在读线程与写线程之间轮转
+static const qint64 kPipeMinSize = 2LL * 1024 * 1024;
+static const int    kPipeBuffers = 4;
+struct PipeChunk { int idx = -1; qint64 len = 0; }; // 缓冲编号 + 有效长度；len <= 0 为结束标记
 
 static QString cleanRel(const QString& rel) {
     QString r = QDir::cleanPath(rel);
@@ -28,6 +65,11 @@ static QString cleanRel(const QString& rel) {
     return r;
 }
 
+// root 下的相对目录（"" = root 本身）
+static QString underRoot(const QString& root, const QString& rel) {
+    return rel.isEmpty() ? QDir(root).absolutePath() : QDir(root).absoluteFilePath(cleanRel(rel));
+}
+
 // ---------- 命名空间 & 路径 ----------
 static QString shortHash(const QString& s) {
     const QByteArray h = QCryptographicHash::hash(s.toUtf8(), QCryptographicHash::Sha1).toHex();
@@ -44,31 +86,71 @@ QString BackupWorker::nsPrefix() const {
 }
 
 QString BackupWorker::nsSubRoot() const {
-    return QDir(m_opt.dstDir).absoluteFilePath(nsPrefix());
+    return m_nsRootAbs;
+}
+
+// rel 来自遍历或已 cleanRel 的白名单，不再逐个规范化
+QString BackupWorker::srcAbsPath(const QString& rel) const {
+    return m_srcRootAbs + QChar('/') + rel;
 }
 
 QString BackupWorker::dstAbsPath(const QString& rel) const {
-    return QDir(nsSubRoot()).absoluteFilePath(cleanRel(rel));
+    return m_nsRootAbs + QChar('/') + rel;
+}
+
+bool BackupWorker::isScopedRun() const {
+    return m_opt.filesWhitelist.isEmpty() && (!m_opt.scopeDirs.isEmpty() || !m_opt.scopeTrees.isEmpty());
+}
+
+// 逐个回调源文件（白名单 > 增量范围 > 全量；已应用忽略规则），visit 返回 false 即中止；完整遍历返回 true
+// 有目录读不了时其余文件照常回调，但返回 false：不完整的扫描不能用来判定删除
+bool BackupWorker::scanSource(const std::function<bool(const QString& rel, const FileStat& st)>& visit) const {
+    if (!m_opt.filesWhitelist.isEmpty()) {
+        PathTable seen; // 重试列表可能重复：同一文件进两个通道会争用同一个 .part 与索引记录
+        for (const QString& r : m_opt.filesWhitelist) {
+            const QString rel = cleanRel(r);
+            if (shouldSkip(rel) || !seen.insert(rel)) continue;
+            if (!visit(rel, statPath(srcAbsPath(rel)))) return false;
+        }
+        return true;
+    }
+    // 遍历自带的 stat，不再单独查询
+    TreeWalker::Options wo;
+    wo.cancelled = [this]{ return stopRequested(); };
+    if (isScopedRun()) {
+        PathTable seen; // 整棵范围与单层范围可能重叠
+        auto walk = [&](const QString& dirRel, bool recursive) {
+            const QString prefix = dirRel.isEmpty() ? QString() : dirRel + QChar('/');
+            wo.recursive = recursive;
+            return TreeWalker::walk(underRoot(m_opt.srcDir, dirRel), wo, [&](TreeWalker::Entry& e) {
+                const QString rel = prefix + e.rel; // 目录已被删除时遍历为空：交给删除处理
+                if (shouldSkip(rel) || !seen.insert(rel)) return true;
+                return visit(rel, e.st);
+            });
+        };
+        // 读不了的目录不中止：继续扫其余范围，只把结果记为不完整；停止才立即返回
+        bool complete = true;
+        for (const QString& d : m_opt.scopeTrees) if (!walk(d, true))  { if (stopRequested()) return false; complete = false; }
+        for (const QString& d : m_opt.scopeDirs)  if (!walk(d, false)) { if (stopRequested()) return false; complete = false; }
+        return complete;
+    }
+    // 源根目录不在（移动盘没挂上、网络盘断开）不等于“全删了”：记为不完整，删除判定随之跳过
+    if (!QFileInfo(m_opt.srcDir).isDir()) return false;
+    return TreeWalker::walk(m_opt.srcDir, wo, [&](TreeWalker::Entry& e) {
+        return shouldSkip(e.rel) || visit(e.rel, e.st);
+    });
 }
 
 QStringList BackupWorker::listAllFiles() const {
     QStringList out;
-    QDirIterator it(m_opt.srcDir, QDir::Files | QDir::NoSymLinks, QDirIterator::Subdirectories);
-    while (it.hasNext()) { it.next(); out << QDir(m_opt.srcDir).relativeFilePath(it.filePath()); }
+    scanSource([&](const QString& rel, const FileStat&){ out << rel; return true; });
     out.sort(Qt::CaseInsensitive);
-    for (QString& s : out) s = cleanRel(s);
     return out;
 }
 
 qint64 BackupWorker::calcTotalBytes() const {
     qint64 sum = 0;
-    const QStringList rels = m_opt.filesWhitelist.isEmpty() ? listAllFiles() : m_opt.filesWhitelist;
-    for (const QString& rel0 : rels) {
-        const QString rel = cleanRel(rel0);
-        if (shouldSkip(rel)) continue;
-        QFileInfo fi(QDir(m_opt.srcDir).absoluteFilePath(rel));
-        if (fi.exists() && fi.isFile()) sum += fi.size();
-    }
+    scanSource([&](const QString&, const FileStat& st){ sum += st.size; return true; });
     return sum;
 }
 
@@ -80,21 +162,82 @@ bool BackupWorker::shouldSkip(const QString& rel) const {
     return false;
 }
 
-QByteArray BackupWorker::fileHashSha256(const QString& path) {
+// 不超过一段时顺序读；更大的文件由 threads 个线程按段并行：各自打开文件，原子计数领段，本线程也领
+QByteArray BackupWorker::fileHash(const QString& path, Digest::Algo algo, BufferPool* pool, double bytesPerSec,
+                                  int threads, QVector<QByteArray>* segmentsOut,
+                                  const std::function<bool()>& cancelled) {
     QFile f(path);
     if (!f.open(QIODevice::ReadOnly)) return {};
-    QCryptographicHash h(QCryptographicHash::Sha256);
-    const qint64 BUF = 1 << 20;
-    QByteArray buf; buf.resize(BUF);
-    qint64 n;
-    while ((n = f.read(buf.data(), BUF)) > 0) {
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-        h.addData(QByteArrayView(buf.constData(), static_cast<qsizetype>(n)));
-#else
-        h.addData(buf.constData(), n);
-#endif
+    const qint64 size = f.size();
+    BufferPool local(0);                   // 未给池：用完即释放
+    BufferPool* bp = pool ? pool : &local;
+    const qint64 bufSize = BufferPool::pickSize(size, bytesPerSec);
+
+    if (size <= TreeDigest::kSegment) {
+        Digest h(algo);
+        const BufferPool::Lease buf = bp->acquire(bufSize);
+        qint64 n;
+        while ((n = f.read(buf.data(), buf.size())) > 0) {
+            if (cancelled && cancelled()) return {};
+            h.addData(buf.data(), n);
+        }
+        if (n < 0) return {};
+        const QByteArray r = h.result();
+        if (segmentsOut) *segmentsOut = {r};
+        return r;
     }
-    return h.result();
+    f.close();
+
+    const int count = int((size + TreeDigest::kSegment - 1) / TreeDigest::kSegment);
+    QVector<QByteArray> segs(count);
+    QByteArray* cells = segs.data();       // 先取指针：各线程只写自己领到的段
+    QAtomicInt next{0}, failed{0};
+    auto hashSegments = [&]{
+        QFile in(path);
+        if (!in.open(QIODevice::ReadOnly)) { failed.storeRelaxed(1); return; }
+        const BufferPool::Lease buf = bp->acquire(bufSize);
+        for (int i = next.fetchAndAddRelaxed(1); i < count && !failed.loadRelaxed(); i = next.fetchAndAddRelaxed(1)) {
+            const qint64 off = qint64(i) * TreeDigest::kSegment;
+            if (!in.seek(off)) { failed.storeRelaxed(1); return; }
+            Digest h(algo);
+            for (qint64 left = qMin(TreeDigest::kSegment, size - off); left > 0; ) {
+                if (cancelled && cancelled()) { failed.storeRelaxed(1); return; }
+                const qint64 n = in.read(buf.data(), qMin(buf.size(), left));
+                if (n <= 0) { failed.storeRelaxed(1); return; } // 读错误，或文件在此期间变短
+                h.addData(buf.data(), n);
+                left -= n;
+            }
+            cells[i] = h.result();
+        }
+    };
+
+    QVector<QThread*> helpers;
+    for (int t = 1; t < qBound(1, threads, count); ++t) {
+        QThread* th = QThread::create(hashSegments);
+        th->setObjectName(QStringLiteral("BackupHash:%1").arg(t));
+        helpers.push_back(th);
+        th->start();
+    }
+    hashSegments();
+    for (QThread* th : helpers) { th->wait(); delete th; }
+    if (failed.loadRelaxed()) return {};
+
+    if (segmentsOut) *segmentsOut = segs;
+    return TreeDigest::combine(algo, segs);
+}
+
+QByteArray BackupWorker::hashFile(const QString& path, QVector<QByteArray>* segmentsOut) const {
+    return fileHash(path, m_opt.hashAlgo, &m_bufPool, double(m_laneBps.loadRelaxed()), hashThreads(),
+                    segmentsOut, [this]{ return stopRequested(); });
+}
+
+// 各复制通道平分 CPU：通道多时每个通道少开摘要线程
+int BackupWorker::hashThreads() const {
+    return qMax(1, QThread::idealThreadCount() / qMax(1, m_opt.copyLanes));
+}
+
+qint64 BackupWorker::ioBufSize(qint64 fileSize) const {
+    return BufferPool::pickSize(fileSize, double(m_laneBps.loadRelaxed()));
 }
 
 bool BackupWorker::ensureDir(const QString& dirPath) {
@@ -122,6 +265,28 @@ QString BackupWorker::versionsRoot() const {
 QString BackupWorker::deletedRoot() const {
     return QDir(metaRoot()).absoluteFilePath("deleted");
 }
+QString BackupWorker::indexFilePath() const {
+    return QDir(metaRoot()).absoluteFilePath("index/" + nsPrefix() + "/files.idx");
+}
+
+QString BackupWorker::chunksRoot() const {
+    return QDir(metaRoot()).absoluteFilePath("chunks");
+}
+
+QString BackupWorker::deltaSigPath(const QString& rel) const {
+    const QByteArray key = QCryptographicHash::hash(cleanRel(rel).toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QDir(metaRoot()).absoluteFilePath("index/" + nsPrefix() + "/sig/" + QString::fromLatin1(key) + ".sig");
+}
+
+bool BackupWorker::deltaPending(const QString& rel) const {
+    return QFile::exists(deltaSigPath(rel) + ".pending");
+}
+
+void BackupWorker::dropDeltaState(const QString& rel) const {
+    const QString sig = deltaSigPath(rel);
+    QFile::remove(sig);
+    QFile::remove(sig + ".pending");
+}
 
 QString BackupWorker::versionFilePath(const QString& rel0, const QString& ts) const {
     const QString rel = cleanRel(rel0);
@@ -141,7 +306,8 @@ QString BackupWorker::deletedFilePath(const QString& rel0, const QString& ts) co
 }
 
 QString BackupWorker::writeMetaJson(const QString& payloadPath, const QString& rel,
-                                    const QString& kind, const QString& ts) const {
+                                    const QString& kind, const QString& ts,
+                                    const QByteArray& digest) const {
     QJsonObject obj{
         {"kind", kind},
         {"ts",   ts},
@@ -149,9 +315,12 @@ QString BackupWorker::writeMetaJson(const QString& payloadPath, const QString& r
         {"dstRoot", m_opt.dstDir},
         {"namespace", nsPrefix()},
         {"rel", rel},
-        {"origAbs", QDir(m_opt.srcDir).absoluteFilePath(rel)},
-        {"payload", payloadPath}
+        {"origAbs", srcAbsPath(rel)},
+        {"payload", payloadPath},
+        {"storage", ChunkStore::isManifest(payloadPath) ? "chunks" : "file"},
+        {"hashAlgo", Digest::name(m_opt.hashAlgo)}
     };
+    if (!digest.isEmpty()) obj.insert("hash", QString::fromLatin1(digest.toHex()));
     const QString metaPath = payloadPath + ".json";
     QFile f(metaPath);
     if (f.open(QIODevice::WriteOnly|QIODevice::Truncate)) {
@@ -163,74 +332,103 @@ QString BackupWorker::writeMetaJson(const QString& payloadPath, const QString& r
 
 // ---------- 设备就绪/同一设备检测 ----------
 bool BackupWorker::isDestReadySameDevice() const {
-    QStorageInfo st(m_opt.dstDir);
-    if (!st.isValid() || !st.isReady() || st.isReadOnly())
-        return false;
-    if (!m_expectedDevice.isEmpty() && st.device() != m_expectedDevice)
-        return false; // 同一盘符/挂载点被其他设备接管
-    return true;
+    return m_device.isReady(); // 可用/就绪/非只读/同一设备，由 DeviceMonitor 维护
 }
 
-void BackupWorker::waitUntilDestReadyOrStopped(const QString& phaseHint) {
-    if (m_stop.loadAcquire()) return;
+bool BackupWorker::recheckDestReady() {
+    return m_device.recheck();
+}
 
-    if (!isDestReadySameDevice() && !m_offlineSignaled) {
-        m_offlineSignaled = true;
-        emit deviceOffline(phaseHint); // 提示：可能未插入/已弹出/卷标变化/只读/不同设备接管
-        emit stateChanged(tr("设备离线/变更，等待中…%1").arg(
-            phaseHint.isEmpty()?QString():QString(" · %1").arg(phaseHint)));
+void BackupWorker::waitUntilDestReadyOrStopped(const QString& phaseHint) {
+    if (stopRequested()) return;
+
+    if (!recheckDestReady()) {
+        QMutexLocker lk(&m_offlineMutex); // 多个复制通道同时掉线时只提示一次
+        if (!m_offlineSignaled) {
+            m_offlineSignaled = true;
+            emit deviceOffline(phaseHint); // 提示：可能未插入/已弹出/卷标变化/只读/不同设备接管
+            emit stateChanged(tr("设备离线/变更，等待中…%1").arg(
+                phaseHint.isEmpty()?QString():QString(" · %1").arg(phaseHint)));
+        }
     }
 
-    while (!isDestReadySameDevice() && !m_stop.loadAcquire()
-           && !QThread::currentThread()->isInterruptionRequested()) {
+    while (!isDestReadySameDevice() && !stopRequested()) {
         QThread::msleep(200); // 缩短等待粒度，加速响应停止
     }
 
-    if (m_offlineSignaled && isDestReadySameDevice()) {
-        m_offlineSignaled = false;
-        emit deviceOnline();
-        emit stateChanged(tr("设备已恢复，继续：%1").arg(
-            phaseHint.isEmpty()?tr("任务"):phaseHint));
+    if (isDestReadySameDevice()) {
+        QMutexLocker lk(&m_offlineMutex);
+        if (m_offlineSignaled) {
+            m_offlineSignaled = false;
+            emit deviceOnline();
+            emit stateChanged(tr("设备已恢复，继续：%1").arg(
+                phaseHint.isEmpty()?tr("任务"):phaseHint));
+        }
     }
 }
 
+bool BackupWorker::stopRequested() const {
+    return m_stop.loadAcquire() || (m_runThread && m_runThread->isInterruptionRequested());
+}
+
 // ---------- 快速相等判断 ----------
-bool BackupWorker::likelySameByStat(const QString& srcAbs, const QString& dstAbs) const {
-    QFileInfo s(srcAbs), d(dstAbs);
-    if (!s.exists() || !d.exists() || !s.isFile() || !d.isFile()) return false;
-    if (s.size() != d.size()) return false;
+bool BackupWorker::likelySameByStat(const FileStat& src, const FileStat& dst) {
+    if (!src.isFile || !dst.isFile) return false;
+    if (src.size != dst.size) return false;
     // mtime 差值 ≤ 2 秒，认为“可能相同”，需要哈希确认；否则就当不同
-    const qint64 diff = std::llabs(s.lastModified().toSecsSinceEpoch() - d.lastModified().toSecsSinceEpoch());
-    return diff <= 2;
+    return std::llabs(src.mtimeMs / 1000 - dst.mtimeMs / 1000) <= 2;
+}
+
+// 目标摘要：目标 size/mtime 与索引记录一致、且记录用的是本任务的算法时直接取用，省去读目标
+QByteArray BackupWorker::dstHashFromIndex(const QString& rel, const FileStat& d) const {
+    FileIndex::Entry e;
+    {
+        QMutexLocker lk(&m_indexMutex);
+        const FileIndex::Entry* p = m_index.find(rel);
+        if (!p || p->digest.isEmpty() || p->digestAlgo != m_opt.hashAlgo) return {};
+        e = *p;
+    }
+    if (!d.isFile || d.size != e.size) return {};
+    if (std::llabs(d.mtimeMs - e.mtimeMs) > 2000) return {};
+    return e.digest;
+}
+
+bool BackupWorker::sameContentAsDest(const QString& rel, const QString& srcAbs, const QString& dstAbs,
+                                     const FileStat& src, const FileStat& dst, QByteArray* srcHashOut) {
+    if (!likelySameByStat(src, dst)) return false;
+    const QByteArray a = hashFile(srcAbs);
+    if (a.isEmpty()) return false;
+    QByteArray b = dstHashFromIndex(rel, dst);
+    if (b.isEmpty()) b = hashFile(dstAbs);
+    if (a != b) return false;
+    if (srcHashOut) *srcHashOut = a;
+    return true;
 }
 
 // ---------- 版本与删除留存 ----------
-bool BackupWorker::maybeStashExistingVersion(const QString& rel0) {
+bool BackupWorker::maybeStashExistingVersion(const QString& rel0, FileStat* dst) {
     if (!m_opt.keepVersionsOnChange) return true;
     const QString rel = cleanRel(rel0);
 
     if (!isDestReadySameDevice()) return true; // 外层会 wait+retry
 
     const QString dstPath = dstAbsPath(rel);
-    if (!QFileInfo::exists(dstPath)) return true;
-
-    const QString srcPath = QDir(m_opt.srcDir).absoluteFilePath(rel);
-
-    // 快速路径：只有“可能相同”时才哈希确认
-    if (likelySameByStat(srcPath, dstPath)) {
-        const QByteArray hashDst = fileHashSha256(dstPath);
-        const QByteArray hashSrc = fileHashSha256(srcPath);
-        if (!hashDst.isEmpty() && hashDst == hashSrc) return false; // 完全相同：不需要版本化&复制
-    }
+    if (!dst->exists) return true;
 
     const QString ts = tsNow();
     const QString outPath = versionFilePath(rel, ts);
     ensureDir(QFileInfo(outPath).absolutePath());
     if (!isDestReadySameDevice()) return true;
 
-    if (moveFileRobust(dstPath, outPath)) {
-        const QString meta = writeMetaJson(outPath, rel, "version", ts);
-        emit versionCreated(rel, outPath, meta);
+    // 分块存储时保留目标原文件：随后的复制会原子替换，增量复制则以它为比对基准
+    const QByteArray digest = dstHashFromIndex(rel, *dst); // 归档前取：移走后 stat 对不上
+    const qint64 size = dst->size;
+    const QString payload = stashToVault(dstPath, outPath, /*keepOriginal*/ true);
+    if (!payload.isEmpty()) {
+        if (!m_opt.chunkStoreVault) *dst = FileStat(); // 整文件已移入留存区
+        const QString meta = writeMetaJson(payload, rel, "version", ts, digest);
+        catalogAdd(VaultCatalog::Kind::Version, rel, ts, payload, size, digest);
+        emit versionCreated(rel, payload, meta);
         return true;
     } else {
         // 空间不足/权限等 → 交由外层标记失败，不覆盖新内容
@@ -238,246 +436,534 @@ bool BackupWorker::maybeStashExistingVersion(const QString& rel0) {
     }
 }
 
-void BackupWorker::handleDeletions(const QSet<QString>& srcSet) {
-    if (!m_opt.keepDeletedInVault) return;
-    if (!isDestReadySameDevice()) { waitUntilDestReadyOrStopped(tr("处理删除项")); if (m_stop.loadAcquire()) return; }
+void BackupWorker::catalogAdd(VaultCatalog::Kind kind, const QString& rel, const QString& ts,
+                              const QString& payload, qint64 size, const QByteArray& digest) {
+    VaultCatalog::Entry e;
+    e.kind    = kind;
+    e.tsMs    = VaultCatalog::tsToMs(ts);
+    e.size    = size;
+    e.algo    = m_opt.hashAlgo;
+    e.hash    = digest;
+    e.rel     = rel;
+    e.payload = payload;
+    e.srcRoot = m_srcRootAbs;
+    // 留存清理只看目录：写不进去时“未记全”标记留着，下次从 .json 边车重建；清理的跳过状态同时作废
+    if (!m_catalog->add(e)) QFile::remove(retentionStatePath());
+}
+
+// 默认整文件移动进留存区；分块存储时切块入库写清单（outPath + .pbm），keepOriginal 为假再删除原文件
+// 成功返回实际归档文件路径，失败返回空
+QString BackupWorker::stashToVault(const QString& fromAbs, const QString& outPath, bool keepOriginal) {
+    m_catalog->beginArchive(); // 先立“未记全”标记：归档后没来得及记进目录时，下次据此重建
+    if (!m_opt.chunkStoreVault)
+        return moveFileRobust(fromAbs, outPath) ? outPath : QString();
+
+    const QString manifest = outPath + ChunkStore::manifestSuffix();
+    if (!m_chunks.storeFile(fromAbs, manifest, [this]{ return stopRequested(); })) {
+        QFile::remove(manifest); // 已写入的块留给垃圾回收
+        return QString();
+    }
+    if (!keepOriginal && !QFile::remove(fromAbs)) { QFile::remove(manifest); return QString(); }
+    return manifest;
+}
+
+// 把目标上的删除项移进留存区；成功后剔除索引记录并登记目录。dst 为目标 stat
+bool BackupWorker::stashDeleted(const QString& rel, const FileStat& dst) {
+    const QString abs = underRoot(nsSubRoot(), rel);
+    const QString ts = tsNow();
+    const QString outPath = deletedFilePath(rel, ts);
+    ensureDir(QFileInfo(outPath).absolutePath());
+    if (!isDestReadySameDevice()) { waitUntilDestReadyOrStopped(tr("处理删除项")); if (stopRequested()) return false; }
+
+    const QByteArray digest = dstHashFromIndex(rel, dst);
+    const QString payload = stashToVault(abs, outPath, /*keepOriginal*/ false);
+    if (payload.isEmpty()) return false;
+
+    dropDeltaState(rel);
+    {
+        // 增量运行不做 retainOnly，删除项的索引记录在这里剔除
+        QMutexLocker lk(&m_indexMutex);
+        m_index.remove(rel);
+    }
+    const QString meta = writeMetaJson(payload, rel, "deleted", ts, digest);
+    catalogAdd(VaultCatalog::Kind::Deleted, rel, ts, payload, dst.size, digest);
+    emit deletedStashed(rel, payload, meta);
+    return true;
+}
+
+// scanComplete：本轮扫描走完了整个范围（没有读不了的目录、没被取消、不是白名单重试）
+// 否则 srcSet 缺的那部分会被当成“源中已删除”，所以不完整时什么也不删
+void BackupWorker::handleDeletions(const PathTable& srcSet, bool scanComplete) {
+    if (!m_opt.keepDeletedInVault || !scanComplete || !m_opt.filesWhitelist.isEmpty()) return;
+    if (!isDestReadySameDevice()) { waitUntilDestReadyOrStopped(tr("处理删除项")); if (stopRequested()) return; }
 
     // 仅在该源的命名空间下清理
     const QString rootNs = nsSubRoot();
     if (!QDir(rootNs).exists()) return;
 
-    QDirIterator it(rootNs, QDir::Files, QDirIterator::Subdirectories);
-    while (it.hasNext() && !m_stop.loadAcquire()) {
-        it.next();
-        const QString abs = it.filePath();
-
-        // 排除元数据目录（位于 dst/.plugbackup_meta，下方遍历不到，这里只是防御）
-        if (abs.contains("/.plugbackup_meta/") || abs.contains("\\.plugbackup_meta\\")) continue;
+    // 删除保护：源中不见的文件又多、又占已知文件的一半以上，多半是源盘没挂好而不是真删了 → 本轮一个不动
+    auto holdMassDeletion = [&](qint64 gone, qint64 known) {
+        if (m_opt.allowMassDeletion || gone < kMassDeletionMinFiles || gone * 2 <= known) return false;
+        m_deletionsHeld = int(gone);
+        emit deletionsHeld(m_deletionsHeld);
+        return true;
+    };
 
-        if (!isDestReadySameDevice()) { waitUntilDestReadyOrStopped(tr("处理删除项")); if (m_stop.loadAcquire()) return; }
+    // 全量运行且索引覆盖目标：上次的清单减去本轮扫描即删除项，只 stat 这些文件，不遍历目标
+    if (!isScopedRun() && m_index.coversDest()) {
+        QStringList gone;
+        qint64 known = 0;
+        {
+            QMutexLocker lk(&m_indexMutex);
+            gone = m_index.relsNotIn(srcSet);
+            known = m_index.size();
+        }
+        if (holdMassDeletion(gone.size(), known)) return;   // 记录留着，确认后的下一轮再处理
+        std::sort(gone.begin(), gone.end());               // 同一目录的删除项挨着处理
+        for (const QString& rel : std::as_const(gone)) {
+            if (stopRequested()) return;
+            if (!isDestReadySameDevice()) { waitUntilDestReadyOrStopped(tr("处理删除项")); if (stopRequested()) return; }
+            const FileStat st = statPath(underRoot(rootNs, rel));
+            if (!st.isFile) {
+                // 目标上已经没有（被外部删掉/从未复制成功）：记录作废即可
+                QMutexLocker lk(&m_indexMutex);
+                m_index.remove(rel);
+                continue;
+            }
+            stashDeleted(rel, st);                          // 失败则记录留着，下次再试
+        }
+        return;
+    }
 
-        // 计算相对路径（相对于 ns 子树）
-        const QString relNs = cleanRel(QDir(rootNs).relativeFilePath(abs));
-        const QString rel   = relNs; // 命名空间以外的“纯相对路径”
+    // 需要比对的目标目录：全量 → 整个命名空间；增量 → 只看范围内的目录（目录, 是否递归）
+    QList<QPair<QString, bool>> roots;
+    if (!isScopedRun()) {
+        roots.append({rootNs, true});
+    } else {
+        for (const QString& d : m_opt.scopeTrees) roots.append({underRoot(rootNs, d), true});
+        for (const QString& d : m_opt.scopeDirs) {
+            const QString dstDir = underRoot(rootNs, d);
+            roots.append({dstDir, false});
+            // 源中已不存在的子目录（整棵删除/改名走）→ 目标侧整棵比对
+            QDirIterator sub(dstDir, QDir::Dirs | QDir::NoDotAndDotDot);
+            while (sub.hasNext()) {
+                const QString abs = sub.next();
+                const QString rel = cleanRel(QDir(rootNs).relativeFilePath(abs));
+                if (!QFileInfo(underRoot(m_opt.srcDir, rel)).isDir()) roots.append({abs, true});
+            }
+        }
+    }
 
-        if (srcSet.contains(rel)) continue; // 源还在 → 不算删除
+    // 全量遍历顺带补齐清单：留在目标上的文件都要有记录（没有的补占位），走完即可改用清单比对
+    const bool fillManifest = !isScopedRun();
+    auto keepOnDest = [&](const QString& rel) {
+        if (!fillManifest) return;
+        QMutexLocker lk(&m_indexMutex);
+        m_index.markPresent(rel);
+    };
 
-        const QString ts = tsNow();
-        const QString outPath = deletedFilePath(rel, ts);
-        ensureDir(QFileInfo(outPath).absolutePath());
-        if (!isDestReadySameDevice()) { waitUntilDestReadyOrStopped(tr("处理删除项")); if (m_stop.loadAcquire()) return; }
+    // 先走完目标只收集删除项，过了删除保护再移走
+    QVector<std::pair<QString, FileStat>> gone;
+    qint64 seen = 0;
+    TreeWalker::Options wo;
+    wo.cancelled = [this]{ return stopRequested(); };
+    for (const auto& r : std::as_const(roots)) {
+        wo.recursive = r.second;
+        const QString prefix = cleanRel(QDir(rootNs).relativeFilePath(r.first));
+        const bool done = TreeWalker::walk(r.first, wo, [&](TreeWalker::Entry& e) {
+            // 相对 ns 子树的“纯相对路径”（元数据目录位于 dst/.plugbackup_meta，不在 ns 子树内）
+            const QString rel = prefix.isEmpty() || prefix == "." ? e.rel : prefix + QChar('/') + e.rel;
+            ++seen;
+            if (srcSet.contains(rel)) keepOnDest(rel);      // 源还在 → 不算删除
+            else gone.push_back({rel, e.st});               // 遍历时的 stat 即目标 stat
+            return true;
+        });
+        if (!done) return;
+    }
 
-        if (moveFileRobust(abs, outPath)) {
-            const QString meta = writeMetaJson(outPath, rel, "deleted", ts);
-            emit deletedStashed(rel, outPath, meta);
+    if (holdMassDeletion(gone.size(), qMax<qint64>(seen, m_index.size()))) {
+        for (const auto& g : std::as_const(gone)) keepOnDest(g.first); // 留在清单里，确认后走清单比对
+    } else {
+        for (const auto& g : std::as_const(gone)) {
+            if (stopRequested()) return;
+            if (!isDestReadySameDevice()) { waitUntilDestReadyOrStopped(tr("处理删除项")); if (stopRequested()) return; }
+            if (!stashDeleted(g.first, g.second)) {
+                if (stopRequested()) return;
+                keepOnDest(g.first);
+            }
         }
     }
+    if (fillManifest) {
+        QMutexLocker lk(&m_indexMutex);
+        m_index.setCoversDest(true);
+    }
 }
 
+RetentionPolicy BackupWorker::retentionPolicy() const {
+    RetentionPolicy p;
+    p.days         = qMax(0, m_opt.retentionDays);
+    p.keepVersions = qMax(0, m_opt.keepVersions);
+    p.keepHourly   = qMax(0, m_opt.keepHourly);
+    p.keepDaily    = qMax(0, m_opt.keepDaily);
+    p.keepWeekly   = qMax(0, m_opt.keepWeekly);
+    return p;
+}
+
+QString BackupWorker::retentionStatePath() const {
+    return QDir(metaRoot()).absoluteFilePath("index/" + nsPrefix() + "/retention.json");
+}
+
+// 留存清理：在留存区目录（vault.cat，带归档时间）上评估策略，只删除到期项，不再遍历 versions/、deleted/
+// 上次清理后目录没有变化、策略相同且还没到下一个按天到期的时刻 → 不读目录直接返回
 void BackupWorker::sweepRetention() {
-    const int days = qMax(0, m_opt.retentionDays);
-    if (days == 0) return;
-    if (!isDestReadySameDevice()) { waitUntilDestReadyOrStopped(tr("清理旧版本")); if (m_stop.loadAcquire()) return; }
-
-    const QDateTime cutoff = QDateTime::currentDateTimeUtc().addDays(-days);
-
-    auto sweepDir = [&](const QString& root, const QString& marker){
-        const QString base = QDir(root).absoluteFilePath(nsPrefix());
-        if (!QDir(base).exists()) return;
-        QDirIterator it(base, QDir::Files, QDirIterator::Subdirectories);
-        while (it.hasNext()) {
-            it.next();
-            const QString file = it.filePath();
-            if (file.endsWith(".json", Qt::CaseInsensitive)) continue;
-            const QString name = QFileInfo(file).fileName();
-            const int pos = name.lastIndexOf(marker);
-            if (pos < 0) continue;
-            const QString tsStr = name.mid(pos+2);
-            QDateTime ts = QDateTime::fromString(tsStr, "yyyyMMdd-HHmmss");
-            ts.setTimeSpec(Qt::UTC);
-            if (!ts.isValid()) continue;
-            if (ts < cutoff) {
-                QFile::remove(file);
-                QFile::remove(file + ".json");
-            }
+    const RetentionPolicy policy = retentionPolicy();
+    if (policy.isNoop()) return;
+    if (!isDestReadySameDevice()) { waitUntilDestReadyOrStopped(tr("清理旧版本")); if (stopRequested()) return; }
+
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    const QString policyKey = QString("d%1-v%2-h%3-d%4-w%5").arg(policy.days).arg(policy.keepVersions)
+                                  .arg(policy.keepHourly).arg(policy.keepDaily).arg(policy.keepWeekly);
+    {
+        QFile sf(retentionStatePath());
+        if (sf.open(QIODevice::ReadOnly)) {
+            const QJsonObject o = QJsonDocument::fromJson(sf.readAll()).object();
+            const qint64 next = qint64(o.value("nextExpiryMs").toDouble(0));
+            if (o.value("policy").toString() == policyKey
+                && qint64(o.value("catalogBytes").toDouble(-1)) == QFileInfo(m_catalog->path()).size()
+                && (next < 0 || nowMs < next))
+                return;
         }
-    };
-    sweepDir(versionsRoot(), ".v");
-    sweepDir(deletedRoot(),  ".d");
+    }
+
+    // 同一文件（种类 + 相对路径）的各个版本为一组
+    std::vector<RetentionPolicy::Item> items;
+    QStringList payloads;                                   // 与 items 同序
+    QHash<QString, quint32> groups;
+    const bool scanned = m_catalog->scan([&](const VaultCatalog::Entry& e){
+        if (e.tsMs <= 0) return;                            // 时间未知（边车损坏）：不按策略删除
+        const QString key = QString::number(int(e.kind)) + QChar('/') + e.rel;
+        auto it = groups.constFind(key);
+        if (it == groups.constEnd()) it = groups.insert(key, quint32(groups.size()));
+        items.push_back({it.value(), e.tsMs});
+        payloads << e.payload;
+    });
+    if (!scanned) return;
+
+    qint64 nextExpiry = 0;
+    const std::vector<quint32> expired = policy.expired(items, nowMs, &nextExpiry);
+
+    bool manifestsRemoved = false;
+    bool complete = true;
+    int  removed = 0;
+    for (quint32 i : expired) {
+        if (stopRequested() || !isDestReadySameDevice()) { complete = false; break; }
+        const QString& file = payloads[int(i)];
+        if (!QFile::remove(file) && QFileInfo::exists(file)) { complete = false; continue; }
+        if (ChunkStore::isManifest(file)) manifestsRemoved = true;   // 已被手工删掉的也从目录去掉
+        QFile::remove(file + ".json");
+        m_catalog->remove(file);
+        ++removed;
+    }
+
+    // 目录里失效记录多于有效项时重写（顺序读的代价只跟有效项走）
+    VaultCatalog::Stats cs;
+    if (removed > 0 && m_catalog->scan([](const VaultCatalog::Entry&){}, &cs)
+        && cs.removed > 1024 && cs.removed > cs.live)
+        m_catalog->compact();
+
+    // 有清单被清掉 → 回收不再被任何命名空间引用的块（块在同一目标盘上共享）
+    if (manifestsRemoved && !stopRequested() && isDestReadySameDevice())
+        m_chunks.collectGarbage({versionsRoot(), deletedRoot()});
+
+    // 记下本次结果：目录大小不变（没有新增/移除）时，计数类规则的结论不会变，只需等天数到期
+    if (complete) {
+        QJsonObject o;
+        o["policy"]       = policyKey;
+        o["catalogBytes"] = double(QFileInfo(m_catalog->path()).size());
+        o["nextExpiryMs"] = nextExpiry == std::numeric_limits<qint64>::max() ? -1.0 : double(nextExpiry);
+        QSaveFile sf(retentionStatePath());
+        if (sf.open(QIODevice::WriteOnly)) {
+            sf.write(QJsonDocument(o).toJson(QJsonDocument::Compact));
+            sf.commit();
+        }
+    }
 }
 
 // ---------- 主流程 ----------
 void BackupWorker::run() {
-    // 记录期望设备指纹（首次就绪时）
-    {
-        QStorageInfo st(m_opt.dstDir);
-        if (st.isValid() && st.isReady())
-            m_expectedDevice = st.device();
-        else
-            m_expectedDevice.clear();
-    }
+    m_runThread = QThread::currentThread();
+
+    // 记录期望设备指纹（此刻就绪时）并开始后台监视；任何出口都停止监视、释放目标目录
+    m_device.start();
+    struct MonitorStop { DeviceMonitor& m; ~MonitorStop() { m.stop(); } } monitorStop{m_device};
 
     // 若启动即离线，等待
     waitUntilDestReadyOrStopped(tr("启动"));
-    if (m_stop.loadAcquire()) { emit finished(false, tr("已取消")); return; }
+    if (stopRequested()) { emit finished(false, tr("已取消")); return; }
+
+    // 载入本命名空间的持久化索引（不存在/损坏 → 空索引，走完整比对）
+    m_index = FileIndex(indexFilePath());
+    m_index.load();
+    m_chunks = ChunkStore(chunksRoot());
+    m_dstStats.reset(new DirStatCache(nsSubRoot()));
+
+    // 从 .json 边车重建目录：旧留存区还没有目录；上次有归档没记进去（写失败/中途拔盘或崩溃）；
+    // 全量运行时还查一遍有没有比目录新的边车（旧版程序写入的归档）。重建后留存清理的跳过状态作废
+    // 任何出口都关闭目录文件
+    const bool vaultDirs = QDir(versionsRoot() + "/" + nsPrefix()).exists() || QDir(deletedRoot() + "/" + nsPrefix()).exists();
+    if (m_catalog->isStale()
+        || (vaultDirs && (!m_catalog->exists()
+                          || (!isScopedRun() && m_opt.filesWhitelist.isEmpty() && m_catalog->hasNewerSidecar())))) {
+        m_catalog->rebuild();
+        QFile::remove(retentionStatePath());
+    }
+    struct CatalogClose { VaultCatalog& c; ~CatalogClose() { c.close(); } } catalogClose{*m_catalog};
 
-    emit stateChanged(QObject::tr("扫描中"));
-    const QStringList relsAll = m_opt.filesWhitelist.isEmpty() ? listAllFiles() : m_opt.filesWhitelist;
+    m_progress->reset();
+    SpeedAverager speed(5000);
+    QElapsedTimer ticker; ticker.start();
+
+    const int laneCount = qBound(1, m_opt.copyLanes, 64);
 
-    // 源文件集合（用于删除处理）
-    QSet<QString> srcSet;
-    for (const QString& r : relsAll) {
-        const QString rel = cleanRel(r);
-        if (!shouldSkip(rel)) srcSet.insert(rel);
+    // 速率/ETA 汇总（节流；只在 run() 所在线程计算，复制通道只累加计数，观察方自己定时读）
+    // 扫描期间总量仍在增长，ETA 随之收敛
+    auto reportProgress = [&]{
+        const qint64 bytesDone  = m_progress->bytesDone.loadRelaxed();
+        const qint64 bytesTotal = m_progress->bytesTotal.loadRelaxed();
+        speed.onProgress(bytesDone);
+        if (ticker.elapsed() > 200) {
+            const double bps = speed.avgBytesPerSec();
+            m_laneBps.storeRelaxed(qint64(bps / laneCount)); // 缓冲大小按单通道吞吐选
+            m_progress->bytesPerSec.storeRelaxed(qint64(bps));
+            const qint64 remain = bytesTotal - bytesDone;
+            m_progress->etaSec.storeRelaxed(bps > 1.0 ? qint64(remain / bps) : -1);
+            ticker.restart();
+        }
+    };
+
+    emit stateChanged(QObject::tr("扫描并复制中"));
+
+    // 流水线：扫描线程边遍历边投递，复制通道从有界队列领取，首个文件不必等全量扫描结束
+    // 队列里带着扫描时的 stat：复制通道不再 stat 源
+    BoundedQueue<std::pair<QString, FileStat>> queue(kScanQueueCapacity);
+    PathTable srcSet;              // 源文件集合（删除处理/索引清理用）：仅扫描线程写入，扫描结束后才读取
+    bool scanComplete = false;     // 扫描被中断时不能据此判定“源中已删除”
+    auto scanner = [&]{
+        const bool complete = scanSource([&](const QString& rel, const FileStat& st){
+            srcSet.insert(rel);
+            m_progress->bytesTotal.fetchAndAddRelaxed(st.size);
+            m_progress->filesTotal.fetchAndAddRelaxed(1);
+            return queue.push({rel, st}, [this]{ return stopRequested(); });
+        });
+        scanComplete = complete && !stopRequested();
+        queue.close();
+    };
+    auto lane = [&]{
+        std::pair<QString, FileStat> item;
+        while (!stopRequested()) {
+            while (m_pause.loadAcquire() && !stopRequested()) QThread::msleep(50);
+            if (!queue.pop(&item, [this]{ return stopRequested(); })) break;
+            processFile(item.first, item.second);
+        }
+    };
+
+    QThread* scanThread = QThread::create(scanner);
+    scanThread->setObjectName(QStringLiteral("BackupScan"));
+    scanThread->start();
+
+    QVector<QThread*> lanes;
+    for (int i = 0; i < laneCount; ++i) {
+        QThread* t = QThread::create(lane);
+        t->setObjectName(QStringLiteral("BackupLane:%1").arg(i));
+        lanes.push_back(t);
+        t->start();
     }
 
-    m_totalBytes = 0;
-    for (const QString& rel : srcSet) {
-        QFileInfo fiSrc(QDir(m_opt.srcDir).absoluteFilePath(rel));
-        if (fiSrc.exists() && fiSrc.isFile()) m_totalBytes += fiSrc.size();
+    while (!scanThread->wait(200)) reportProgress();
+    delete scanThread;
+    if (!stopRequested()) emit stateChanged(QObject::tr("复制中"));
+
+    for (QThread* t : lanes) {
+        while (!t->wait(200)) reportProgress();
+        delete t;
     }
-    emit progressUpdated(0, m_totalBytes);
+    reportProgress();
 
-    qint64 bytesDone = 0;
-    bool allOk = true;
-    SpeedAverager speed(5000);
-    QElapsedTimer ticker; ticker.start();
+    // 删除处理（仅在完整扫描后；白名单重试只覆盖部分文件，不能据此判定删除）
+    m_deletionsHeld = 0;
+    if (!stopRequested() && scanComplete && m_opt.filesWhitelist.isEmpty()) {
+        waitUntilDestReadyOrStopped(tr("处理删除项"));
+        if (!stopRequested()) handleDeletions(srcSet, scanComplete);
+    }
 
-    emit stateChanged(QObject::tr("复制中"));
+    // 清理保留期
+    if (!stopRequested()) {
+        waitUntilDestReadyOrStopped(tr("清理旧版本"));
+        if (!stopRequested()) sweepRetention();
+    }
 
-    for (const QString& rel : srcSet) {
-        if (m_stop.loadAcquire()) break;
-        while (m_pause.loadAcquire() && !m_stop.loadAcquire()) QThread::msleep(50);
+    // 保存索引：全量扫描时顺带剔除源中已不存在的记录；取消时也保存已完成部分
+    // 索引兼作目标清单时删除项已在 handleDeletions 里逐条剔除，没能移走的仍在目标上，记录要留着
+    if (!stopRequested() && scanComplete && m_opt.filesWhitelist.isEmpty() && !isScopedRun()
+        && !(m_opt.keepDeletedInVault && m_index.coversDest())) {
+        m_index.retainOnly(srcSet);
+        m_index.setCoversDest(false);                       // 不移走删除项时目标上会留着源已删的文件
+    }
+    if (recheckDestReady()) m_index.save();
+
+    // 中途取消的不算成功：没轮到的文件既没复制也没报失败
+    const bool stopped = stopRequested();
+    // 暂缓的删除项也不算完成：目标上还留着源中已不见的文件，等确认
+    const bool allOk = !stopped && m_progress->filesFailed.loadAcquire() == 0 && m_deletionsHeld == 0;
+    m_progress->bytesDone.storeRelaxed(m_progress->bytesTotal.loadRelaxed());
+    m_progress->bytesPerSec.storeRelaxed(0);
+    m_progress->etaSec.storeRelaxed(0);
+    emit finished(allOk, stopped ? tr("已取消")
+                         : m_deletionsHeld > 0 ? tr("删除项过多（%1 个），已暂缓移走，待确认").arg(m_deletionsHeld)
+                         : allOk ? QObject::tr("完成") : QObject::tr("部分失败"));
+}
 
-        const QString srcPath = QDir(m_opt.srcDir).absoluteFilePath(rel);
-        QFileInfo fiSrc(srcPath);
-        if (!fiSrc.exists() || !fiSrc.isFile()) continue;
+void BackupWorker::processFile(const QString& rel, const FileStat& st) {
+    const QString srcPath = srcAbsPath(rel);
 
-        emit fileStarted(rel, fiSrc.size());
+    auto fail = [&](const QString& err){
+        m_progress->filesFailed.fetchAndAddRelaxed(1);
+        m_progress->filesDone.fetchAndAddRelaxed(1);
+        emit fileFailed(rel, err);
+    };
 
-        // 设备就绪保障
-        waitUntilDestReadyOrStopped(tr("准备复制"));
-        if (m_stop.loadAcquire()) break;
+    // 白名单重试里的文件不经遍历，可能已不在：照样计入完成并报出，计数与失败列表才对得上
+    if (!st.exists) { fail(tr("源文件已消失")); return; }
+    if (!st.isFile) { fail(tr("源路径不是文件")); return; }
 
-        // 若目标存在，先做“版本化或跳过”
-        if (QFileInfo::exists(dstAbsPath(rel))) {
-            bool r = maybeStashExistingVersion(rel);
-            if (!isDestReadySameDevice()) { // 期间设备变更 → 重来
-                waitUntilDestReadyOrStopped(tr("版本化"));
-                if (m_stop.loadAcquire()) break;
-                r = maybeStashExistingVersion(rel);
-            }
-            if (!r) { // 版本化失败，标记文件失败并跳过复制
-                emit fileFinished(rel, false, QObject::tr("版本归档失败"));
-                allOk = false;
-                continue;
-            }
-            // 若返回 false 表示“完全相同”→ 已在 maybeStashExistingVersion 中处理为“跳过复制”
-            // 但我们这里为清晰起见再检测一次：如果目标仍在且与源完全一致，就跳过并累加进度
-            const QString dstPath = dstAbsPath(rel);
-            if (QFileInfo::exists(dstPath) && likelySameByStat(srcPath, dstPath)) {
-                const QByteArray a = fileHashSha256(srcPath);
-                const QByteArray b = fileHashSha256(dstPath);
-                if (!a.isEmpty() && a == b) {
-                    bytesDone += fiSrc.size();
-                    emit fileFinished(rel, true, QString());
-                    // 刷新速率与进度（节流）
-                    speed.onProgress(bytesDone);
-                    if (ticker.elapsed() > 200) {
-                        const double bps = speed.avgBytesPerSec();
-                        emit speedUpdated(bps);
-                        const qint64 remain = m_totalBytes - bytesDone;
-                        const qint64 eta = bps > 1.0 ? qint64(remain / bps) : -1;
-                        emit etaUpdated(eta);
-                        emit progressUpdated(bytesDone, m_totalBytes);
-                        ticker.restart();
-                    }
-                    continue;
-                }
-            }
+    // 索引命中：与上次成功备份时 size/mtime/文件ID 一致 → 不读源内容、不访问目标
+    {
+        QMutexLocker lk(&m_indexMutex);
+        if (m_index.matches(rel, st)) {
+            lk.unlock();
+            m_progress->bytesDone.fetchAndAddRelaxed(st.size);
+            m_progress->filesDone.fetchAndAddRelaxed(1);
+            return;
         }
+    }
 
-        // 复制 + 离线自动等待重试
-        for (;;) {
-            if (m_stop.loadAcquire()) break;
-            while (m_pause.loadAcquire() && !m_stop.loadAcquire()) QThread::msleep(50);
-
-            if (!isDestReadySameDevice()) {
-                waitUntilDestReadyOrStopped(tr("复制"));
-                if (m_stop.loadAcquire()) break;
-                continue; // 设备恢复后再试
-            }
 
-            bool ok = copyOneFile(rel, &bytesDone);
-            if (!ok) {
-                if (!isDestReadySameDevice()) {
-                    // 复制过程中设备掉线：等待、再试
-                    waitUntilDestReadyOrStopped(tr("复制重试"));
-                    if (m_stop.loadAcquire()) break;
-                    continue;
-                }
-                emit fileFinished(rel, false, QObject::tr("复制失败"));
-                allOk = false;
-                break;
-            }
+    // 设备就绪保障
+    waitUntilDestReadyOrStopped(tr("准备复制"));
+    if (stopRequested()) return;
 
-            if (m_opt.verifyAfterWrite) {
-                emit stateChanged(QObject::tr("校验中 · %1").arg(rel));
-                bool vok = verifyFile(rel);
-                if (!vok) {
-                    if (!isDestReadySameDevice()) {
-                        waitUntilDestReadyOrStopped(tr("校验重试"));
-                        if (m_stop.loadAcquire()) break;
-                        continue; // 回到 copy 再来一遍最稳妥
-                    }
-                    emit fileFinished(rel, false, QObject::tr("校验失败"));
-                    allOk = false;
-                    break;
-                }
+    // 若目标存在：内容相同则跳过（补记索引），否则先版本化
+    // 上次增量改写中断的目标内容新旧混杂：既不算相同也不当作历史版本，直接交给复制修复
+    // 目标 stat 只取这一次（同目录文件多时成批取得），之后随归档/复制结果更新
+    const QString dstPath = dstAbsPath(rel);
+    FileStat dst = m_dstStats->take(rel);
+    if (dst.exists && !deltaPending(rel)) {
+        QByteArray sameHash;
+        if (sameContentAsDest(rel, srcPath, dstPath, st, dst, &sameHash)) {
+            {
+                QMutexLocker lk(&m_indexMutex);
+                m_index.put(rel, {st.size, st.mtimeMs, st.fileId, sameHash, m_opt.hashAlgo});
             }
-
-            // 成功
-            emit fileFinished(rel, true, QString());
-            break;
+            m_progress->bytesDone.fetchAndAddRelaxed(st.size);
+            m_progress->filesDone.fetchAndAddRelaxed(1);
+            return;
         }
 
-        // 速率/ETA 更新（节流）
-        speed.onProgress(bytesDone);
-        if (ticker.elapsed() > 200) {
-            const double bps = speed.avgBytesPerSec();
-            emit speedUpdated(bps);
-            const qint64 remain = m_totalBytes - bytesDone;
-            const qint64 eta = bps > 1.0 ? qint64(remain / bps) : -1;
-            emit etaUpdated(eta);
-            emit progressUpdated(bytesDone, m_totalBytes);
-            ticker.restart();
+        bool r = maybeStashExistingVersion(rel, &dst);
+        if (!recheckDestReady()) { // 期间设备变更 → 重来
+            waitUntilDestReadyOrStopped(tr("版本化"));
+            if (stopRequested()) return;
+            dst = statPath(dstPath);
+            r = maybeStashExistingVersion(rel, &dst);
+        }
+        if (!r) { // 版本化失败，标记文件失败并跳过复制
+            if (stopRequested()) return; // 切块入库被取消，不算失败
+            fail(QObject::tr("版本归档失败"));
+            return;
         }
     }
 
-    // 删除处理
-    if (!m_stop.loadAcquire()) {
-        waitUntilDestReadyOrStopped(tr("处理删除项"));
-        if (!m_stop.loadAcquire()) handleDeletions(srcSet);
+    // 内容即将改变：成功之前不再信任旧记录（留占位：复制失败时目标上也可能有半个文件，清单里不能丢）
+    {
+        QMutexLocker lk(&m_indexMutex);
+        m_index.invalidate(rel);
     }
 
-    // 清理保留期
-    if (!m_stop.loadAcquire()) {
-        waitUntilDestReadyOrStopped(tr("清理旧版本"));
-        if (!m_stop.loadAcquire()) sweepRetention();
+    // 复制 + 离线自动等待重试
+    QByteArray srcHash;
+    QVector<QByteArray> srcSegs;                         // 大文件的分段摘要：校验不一致时只重写坏段
+    FileStat src = st;                                   // 源在复制后被改动时按新 stat 重来
+    int sourceChanges = 0;
+    for (bool retry = false; ; retry = true) {
+        if (stopRequested()) return;
+        while (m_pause.loadAcquire() && !stopRequested()) QThread::msleep(50);
+
+        if (!isDestReadySameDevice()) {
+            waitUntilDestReadyOrStopped(tr("复制"));
+            if (stopRequested()) return;
+            continue; // 设备恢复后再试
+        }
+
+        if (retry) dst = statPath(dstPath);              // 上一次尝试可能已改动目标
+        bool ok = copyOneFile(rel, src, dst, &srcHash, &srcSegs);
+        if (!ok) {
+            if (!recheckDestReady()) {
+                // 复制过程中设备掉线：等待、再试
+                waitUntilDestReadyOrStopped(tr("复制重试"));
+                if (stopRequested()) return;
+                continue;
+            }
+            fail(QObject::tr("复制失败"));
+            return;
+        }
+
+        if (m_opt.verifyAfterWrite) {
+            const Verify v = verifyFile(rel, srcHash, srcSegs);
+            if (v != Verify::Ok) {
+                dropDeltaState(rel); // 签名描述的是“应写入”的内容，校验不过就不能再信
+                if (stopRequested()) return;
+                if (!recheckDestReady()) {
+                    waitUntilDestReadyOrStopped(tr("校验重试"));
+                    if (stopRequested()) return;
+                    continue; // 回到 copy 再来一遍最稳妥
+                }
+                if (v == Verify::SourceChanged) {
+                    // 源在复制后被改动：按新内容整文件重来；一直在变就算失败
+                    if (++sourceChanges > m_opt.maxRetries) { fail(QObject::tr("源文件在复制期间持续变化")); return; }
+                    src = statPath(srcPath);
+                    if (!src.isFile) { fail(QObject::tr("源文件已消失")); return; }
+                    continue;
+                }
+                fail(QObject::tr("校验失败"));
+                return;
+            }
+        }
+        break;
     }
 
-    emit progressUpdated(m_totalBytes, m_totalBytes);
-    emit finished(allOk, allOk ? QObject::tr("完成") : QObject::tr("部分失败"));
+    // 成功。记录复制前的源 stat：若复制期间源被改动，下次 stat 不一致会重新比对
+    {
+        QMutexLocker lk(&m_indexMutex);
+        m_index.put(rel, {src.size, src.mtimeMs, src.fileId, srcHash, m_opt.hashAlgo});
+    }
+    m_progress->filesCopied.fetchAndAddRelaxed(1);
+    m_progress->filesDone.fetchAndAddRelaxed(1);
 }
 
-bool BackupWorker::copyOneFile(const QString& rel0, qint64* bytesDone) {
+// src/dst 为调用方已取得的 stat（src 来自扫描），这里不再重复查询
+bool BackupWorker::copyOneFile(const QString& rel0, const FileStat& src, const FileStat& dst,
+                               QByteArray* srcHashOut, QVector<QByteArray>* srcSegmentsOut) {
     const QString rel = cleanRel(rel0);
-    const QString srcPath = QDir(m_opt.srcDir).absoluteFilePath(rel);
+    const QString srcPath = srcAbsPath(rel);
     const QString dstPath = dstAbsPath(rel);
 
     if (!isDestReadySameDevice()) return false;
 
-    if (!ensureDir(QFileInfo(dstPath).absolutePath())) return false;
+    // 大文件且目标已有旧内容 → 增量复制
+    if (m_opt.deltaTransfer && dst.isFile && src.size >= kDeltaMinSize)
+        return copyDeltaInPlace(rel, src, dst, srcHashOut, srcSegmentsOut);
+
+    if (!dst.exists && !ensureDir(QFileInfo(dstPath).absolutePath())) return false; // 目标在 → 目录必在
     if (!isDestReadySameDevice()) return false;
 
     QFile in(srcPath);
@@ -489,20 +975,59 @@ bool BackupWorker::copyOneFile(const QString& rel0, qint64* bytesDone) {
         return false;
     }
 
-    const qint64 BUF = 1 << 20; // 1MB
-    QByteArray buf; buf.resize(BUF);
-    qint64 n;
-    QElapsedTimer t; t.start();
-    qint64 sentInWindow = 0;
-    const int windowMs = 100;
+    TreeDigest h(m_opt.hashAlgo);                     // 源摘要：与写入同一缓冲，省去校验时重读源
+    bool buffered = true;                             // 内核侧/异步路径已复制完则不再走缓冲循环
+    bool hashed   = true;                             // 数据经过用户态，h 即完整源摘要
+
+#ifdef Q_OS_LINUX
+    // 内核侧复制：拿不到源摘要，只有不做写后校验时才用 copy_file_range；reflink 不写数据，总是先试
+    switch (copyKernelSide(in, out, /*allowCopyRange*/ !m_opt.verifyAfterWrite)) {
+    case KernelCopy::Failed:
+        out.close(); QFile::remove(dstPath + ".part"); in.close();
+        return false;
+    case KernelCopy::Done:
+        buffered = false;
+        hashed = false;
+        break;
+    case KernelCopy::Unsupported:
+        break;
+    }
+
+    // 异步读写：源读与目标写重叠（内核不支持/被禁用时走下面的缓冲循环）
+    if (buffered) {
+        switch (copyIoUring(in, out, &h)) {
+        case KernelCopy::Failed:
+            out.close(); QFile::remove(dstPath + ".part"); in.close();
+            return false;
+        case KernelCopy::Done:
+            buffered = false;
+            break;
+        case KernelCopy::Unsupported:
+            break;
+        }
+    }
+#endif
 
-    while ((n = in.read(buf.data(), BUF)) > 0) {
-        if (m_stop.loadAcquire() || QThread::currentThread()->isInterruptionRequested()) {
+    // 大文件：读线程预读，本线程只管写，源盘与目标盘不再轮流空闲
+    if (buffered && src.size >= kPipeMinSize) {
+        if (!copyPipelined(in, out, &h)) {
             out.close(); QFile::remove(dstPath + ".part"); in.close();
             return false;
         }
-        while (m_pause.loadAcquire() && !m_stop.loadAcquire()
-               && !QThread::currentThread()->isInterruptionRequested()) {
+        buffered = false;
+    }
+
+    // 缓冲按文件大小与实测吞吐取（小文件不再分配 1MB），从池中复用
+    BufferPool::Lease buf;
+    if (buffered) buf = m_bufPool.acquire(ioBufSize(src.size));
+    qint64 n = 0;
+
+    while (buffered && (n = in.read(buf.data(), buf.size())) > 0) {
+        if (stopRequested()) {
+            out.close(); QFile::remove(dstPath + ".part"); in.close();
+            return false;
+        }
+        while (m_pause.loadAcquire() && !stopRequested()) {
             QThread::msleep(50);
         }
 
@@ -514,69 +1039,431 @@ bool BackupWorker::copyOneFile(const QString& rel0, qint64* bytesDone) {
             return false;
         }
 
-        if (m_opt.speedLimitBps > 0) {
-            const qint64 budgetWindow = (m_opt.speedLimitBps * windowMs) / 1000;
-            if (sentInWindow + n > budgetWindow) {
-                const int elapsed = int(t.elapsed());
-                if (elapsed < windowMs) QThread::msleep(windowMs - elapsed);
-                t.restart();
-                sentInWindow = 0;
-            }
-        }
+        // 限速：所有复制通道共享同一预算
+        m_limiter.consume(n, [this]{ return stopRequested(); });
 
-        qint64 w = out.write(buf.constData(), n);
+        qint64 w = out.write(buf.data(), n);
         if (w != n) {
             out.close();
             QFile::remove(dstPath + ".part");
             in.close();
             return false;
         }
-        *bytesDone += n;
-        if (m_opt.speedLimitBps > 0) sentInWindow += n;
+        h.addData(buf.data(), n);
+        m_progress->bytesDone.fetchAndAddRelaxed(n);
     }
 
-    out.flush(); out.close(); in.close();
+    if (n < 0) { // 读源出错：不能把半截内容当成完整文件
+        out.close(); QFile::remove(dstPath + ".part"); in.close();
+        return false;
+    }
+
+    out.flush();
+    // 目标 mtime 调整为扫描时的源 mtime（更友好）：趁 .part 还开着设置，改名后保留，不再重开目标、stat 源
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    out.setFileTime(QDateTime::fromMSecsSinceEpoch(src.mtimeMs), QFileDevice::FileModificationTime);
+#endif
+    out.close(); in.close();
 
-    // 原子替换
-    QFile::remove(dstPath);
-    if (!QFile::rename(dstPath + ".part", dstPath)) {
+    // 原子替换（快照说目标不存在就不先删；快照过时则删后再试一次）
+    if (dst.exists) QFile::remove(dstPath);
+    if (!QFile::rename(dstPath + ".part", dstPath)
+        && (dst.exists || !QFile::remove(dstPath) || !QFile::rename(dstPath + ".part", dstPath))) {
         QFile::remove(dstPath + ".part");
         return false;
     }
+    dropDeltaState(rel); // 整文件替换后旧签名失效
+    if (srcHashOut) *srcHashOut = hashed ? h.result() : QByteArray(); // 空 → 校验时再读源
+    if (srcSegmentsOut) *srcSegmentsOut = hashed ? h.segments() : QVector<QByteArray>();
+    return true;
+}
 
-    // 可选：把目标 mtime 调整为源 mtime（更友好）
-    QFileInfo fiSrc(srcPath);
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-    QFile dst(dstPath);
-    if (dst.open(QIODevice::ReadWrite)) {
-        dst.setFileTime(fiSrc.lastModified(), QFileDevice::FileModificationTime);
-        dst.close();
+// 读线程：取空缓冲 → 读源 → 算摘要 → 交给写方；写方（本线程）：暂停/停止/离线检查 → 限速 → 写 → 归还缓冲
+// 两个方向各一个无锁 SPSC 环
+bool BackupWorker::copyPipelined(QFile& in, QFile& out, TreeDigest* h) {
+    const qint64 bufSize = ioBufSize(in.size());
+    BufferPool::Lease bufs[kPipeBuffers];
+    for (auto& b : bufs) b = m_bufPool.acquire(bufSize);
+    auto bufAt = [&](int i) { return bufs[i].data(); };
+
+    SpscRing<int>   freeRing(kPipeBuffers);
+    SpscRing<PipeChunk> fullRing(kPipeBuffers);
+    for (int i = 0; i < kPipeBuffers; ++i) freeRing.tryPush(i);
+
+    QAtomicInt abort{0};
+    auto aborted = [&]{ return abort.loadAcquire() != 0; };
+
+    QThread* reader = QThread::create([&]{
+        int idx = -1;
+        while (freeRing.pop(&idx, aborted)) {
+            const qint64 n = in.read(bufAt(idx), bufSize);
+            if (n > 0) {
+                h->addData(bufAt(idx), n);
+            }
+            if (!fullRing.push(PipeChunk{idx, n}, aborted) || n <= 0) break;
+        }
+    });
+    reader->setObjectName(QStringLiteral("BackupRead"));
+    reader->start();
+
+    bool ok = true;
+    PipeChunk c;
+    for (;;) {
+        if (!fullRing.pop(&c, [this]{ return stopRequested(); })) { ok = false; break; }
+        if (c.len <= 0) { ok = c.len == 0; break; } // 0 = 读完；< 0 = 读源出错
+        while (m_pause.loadAcquire() && !stopRequested()) QThread::msleep(50);
+        if (stopRequested() || !isDestReadySameDevice()) { ok = false; break; }
+
+        m_limiter.consume(c.len, [this]{ return stopRequested(); });
+        if (out.write(bufAt(c.idx), c.len) != c.len) { ok = false; break; }
+        m_progress->bytesDone.fetchAndAddRelaxed(c.len);
+        freeRing.tryPush(c.idx); // 缓冲总数 = 环容量，不会满
+    }
+
+    abort.storeRelease(1);
+    reader->wait();
+    delete reader;
+    return ok;
+}
+
+#ifdef Q_OS_LINUX
+// 1) FICLONE：源与目标在同一 btrfs/XFS 上时共享数据块，不产生数据写入；
+// 2) copy_file_range：数据不经过用户态缓冲，按 8MB 有界分块推进，块间照常限速/暂停/停止/离线检查。
+// 都不可用（跨文件系统、旧内核、FAT/exFAT 等）且尚未写入任何数据时返回 Unsupported，交给缓冲复制。
+BackupWorker::KernelCopy BackupWorker::copyKernelSide(QFile& in, QFile& out, bool allowCopyRange) {
+    const int inFd = in.handle(), outFd = out.handle();
+    if (inFd < 0 || outFd < 0) return KernelCopy::Unsupported;
+
+#ifdef FICLONE
+    if (::ioctl(outFd, FICLONE, inFd) == 0) {
+        m_progress->bytesDone.fetchAndAddRelaxed(in.size());
+        return KernelCopy::Done;
     }
 #endif
+    if (!allowCopyRange) return KernelCopy::Unsupported;
+
+    const size_t CHUNK = size_t(8) << 20;
+    qint64 done = 0;
+    for (;;) {
+        if (stopRequested()) return KernelCopy::Failed;
+        while (m_pause.loadAcquire() && !stopRequested()) QThread::msleep(50);
+        if (!isDestReadySameDevice()) return KernelCopy::Failed;
+
+        const ssize_t n = ::copy_file_range(inFd, nullptr, outFd, nullptr, CHUNK, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (done == 0 && (errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP
+                              || errno == EINVAL || errno == EBADF))
+                return KernelCopy::Unsupported; // 文件偏移未动，缓冲复制可从头开始
+            return KernelCopy::Failed;
+        }
+        if (n == 0) break; // 源读到末尾
+        done += n;
+        m_progress->bytesDone.fetchAndAddRelaxed(n);
+        m_limiter.consume(n, [this]{ return stopRequested(); }); // 事后记账：下一块前补足等待
+    }
+    return KernelCopy::Done;
+}
+#endif
+
+// io_uring：多个槽按偏移并发读写，缓冲注册成功时走 *_FIXED 省去每次钉页。
+// 槽的生命周期：空闲 → 读 → 已读（按偏移顺序算摘要、限速）→ 写 → 空闲；短读/短写就地续提交
+BackupWorker::KernelCopy BackupWorker::copyIoUring(QFile& in, QFile& out, TreeDigest* h) {
+    const int inFd = in.handle(), outFd = out.handle();
+    const qint64 size = in.size();
+    if (inFd < 0 || outFd < 0 || size < kUringMinSize) return KernelCopy::Unsupported;
+
+    // 声明顺序：ring 后声明、先析构，关闭后内核不再引用缓冲，租约才归还
+    const qint64 slotBytes = qMin(ioBufSize(size), kUringSlotMax);
+    BufferPool::Lease bufs[kUringSlots];
+    for (auto& b : bufs) b = m_bufPool.acquire(slotBytes);
+    IoUring ring;
+    if (!ring.init(kUringSlots * 2)) return KernelCopy::Unsupported; // 老内核 / kernel.io_uring_disabled
+
+    iovec iov[kUringSlots];
+    for (int i = 0; i < kUringSlots; ++i) {
+        iov[i].iov_base = bufs[i].data();
+        iov[i].iov_len  = size_t(slotBytes);
+    }
+    ring.registerBuffers(iov, unsigned(kUringSlots)); // 失败则用普通读写，只是每次多一次页钉住
+
+    enum class St { Free, Reading, Read, Writing };
+    struct Slot { St st = St::Free; qint64 off = 0; unsigned len = 0; unsigned done = 0; };
+    Slot cells[kUringSlots];
+    auto slotBuf = [&](int i) { return static_cast<char*>(iov[i].iov_base); };
+    auto submit = [&](int i) {
+        const Slot& s = cells[i];
+        return s.st == St::Reading
+            ? ring.prepRead(inFd, slotBuf(i) + s.done, s.len - s.done, quint64(s.off + s.done), i, quint64(i))
+            : ring.prepWrite(outFd, slotBuf(i) + s.done, s.len - s.done, quint64(s.off + s.done), i, quint64(i));
+    };
+
+    qint64 nextRead = 0, hashed = 0, written = 0;
+    int inflight = 0;
+    KernelCopy result = KernelCopy::Done;
+
+    while (written < size && result == KernelCopy::Done) {
+        // 1) 空闲槽发起读：读不限速，写出前才记账
+        for (int i = 0; i < kUringSlots && nextRead < size; ++i) {
+            Slot& s = cells[i];
+            if (s.st != St::Free) continue;
+            s.st = St::Reading; s.off = nextRead; s.done = 0;
+            s.len = unsigned(qMin<qint64>(slotBytes, size - nextRead));
+            if (!submit(i)) { s.st = St::Free; break; }
+            nextRead += s.len; ++inflight;
+        }
+
+        // 2) 已读的槽按偏移顺序：暂停/停止/离线检查 → 发起写 → 限速 → 摘要
+        //    提交成功后才记账：提交队列满时槽退回“已读”，下一轮不能重复计入摘要与限速
+        for (bool progressed = true; progressed && result == KernelCopy::Done; ) {
+            progressed = false;
+            for (int i = 0; i < kUringSlots; ++i) {
+                Slot& s = cells[i];
+                if (s.st != St::Read || s.off != hashed) continue;
+                while (m_pause.loadAcquire() && !stopRequested()) QThread::msleep(50);
+                if (stopRequested() || !isDestReadySameDevice()) { result = KernelCopy::Failed; break; }
+                s.st = St::Writing; s.done = 0;
+                if (!submit(i)) { s.st = St::Read; break; } // 提交队列满：等完成后再来
+                m_limiter.consume(s.len, [this]{ return stopRequested(); });
+                h->addData(slotBuf(i), s.len);
+                hashed += s.len; ++inflight; progressed = true;
+            }
+        }
+        if (result != KernelCopy::Done) break;
+
+        // 3) 提交并至少等一个完成
+        if (ring.submitAndWait(inflight > 0 ? 1u : 0u) < 0) { result = KernelCopy::Failed; break; }
+
+        // 4) 收完成项
+        quint64 tag = 0; int res = 0;
+        while (ring.popCompletion(&tag, &res)) {
+            --inflight;
+            Slot& s = cells[int(tag)];
+            if (res < 0) {
+                // IORING_OP_READ/WRITE 需要 5.6+：摘要里还没有任何数据就退回缓冲循环（文件偏移未动，h 仍是空的）
+                const bool noOp = res == -EINVAL || res == -EOPNOTSUPP;
+                result = (noOp && hashed == 0 && result != KernelCopy::Failed) ? KernelCopy::Unsupported
+                                                                                 : KernelCopy::Failed;
+                continue;
+            }
+            if (res == 0) { result = KernelCopy::Failed; continue; } // 源在复制期间被截短
+            s.done += unsigned(res);
+            if (s.done < s.len) { // 短读/短写：续上剩余部分
+                if (submit(int(tag))) ++inflight; else result = KernelCopy::Failed;
+                continue;
+            }
+            if (s.st == St::Reading) {
+                s.st = St::Read;
+            } else {
+                s.st = St::Free;
+                written += s.len;
+                m_progress->bytesDone.fetchAndAddRelaxed(s.len);
+            }
+        }
+    }
+
+    // 缓冲仍被内核引用：收齐在途请求再返回
+    while (inflight > 0 && ring.submitAndWait(1) >= 0) {
+        quint64 tag = 0; int res = 0;
+        while (ring.popCompletion(&tag, &res)) --inflight;
+    }
+    return result;
+}
+
+// 增量复制：逐块比对源与目标旧内容的 SHA-256（优先用签名缓存，失效则回读目标），
+// 只把不同的块原地写入目标，多余尾部截断。改写期间留 .pending 标记：
+// 中途掉线/崩溃时目标新旧混杂，下次运行据此跳过“相同/版本化”判断并重新比对修复。
+bool BackupWorker::copyDeltaInPlace(const QString& rel, const FileStat& src, const FileStat& d,
+                                    QByteArray* srcHashOut, QVector<QByteArray>* srcSegmentsOut) {
+    const QString srcPath = srcAbsPath(rel);
+    const QString dstPath = dstAbsPath(rel);
+    const QString sigPath = deltaSigPath(rel);
+    const QString pendingPath = sigPath + ".pending";
+
+    BlockSignature old;
+    if (QFile::exists(pendingPath) || !old.load(sigPath)
+        || old.fileSize != d.size || old.mtimeMs != d.mtimeMs || old.blockSize != BlockSignature::kBlockSize)
+        old = BlockSignature(); // 缓存不可信 → 逐块回读目标
+
+    QFile in(srcPath);
+    if (!in.open(QIODevice::ReadOnly)) return false;
+    QFile out(dstPath);
+    if (!out.open(QIODevice::ReadWrite)) return false;
+
+    if (!ensureDir(QFileInfo(pendingPath).absolutePath())) return false;
+    {
+        QFile mark(pendingPath);
+        if (!mark.open(QIODevice::WriteOnly)) return false;
+    }
+
+    const qint64 B = BlockSignature::kBlockSize;
+    QByteArray buf; buf.resize(B);
+    QByteArray dbuf; dbuf.resize(B);
+    TreeDigest h(m_opt.hashAlgo);
+    BlockSignature fresh;
+    qint64 off = 0, n;
+
+    while ((n = in.read(buf.data(), B)) > 0) {
+        if (stopRequested()) return false; // 保留 .pending，下次修复
+        while (m_pause.loadAcquire() && !stopRequested()) QThread::msleep(50);
+        if (!isDestReadySameDevice()) return false;
+
+        m_limiter.consume(n, [this]{ return stopRequested(); });
+
+        const QByteArray newDigest = BlockSignature::blockDigest(buf.constData(), n);
+        const int idx = int(off / B);
+        QByteArray oldDigest;
+        if (idx < old.blockCount()) {
+            oldDigest = old.digestAt(idx);
+        } else if (off < d.size) {
+            if (!out.seek(off)) return false;
+            const qint64 r = out.read(dbuf.data(), n);
+            if (r == n) oldDigest = BlockSignature::blockDigest(dbuf.constData(), r);
+        }
+        if (oldDigest != newDigest) {
+            if (!out.seek(off) || out.write(buf.constData(), n) != n) return false;
+        }
+        fresh.append(newDigest);
+        h.addData(buf.constData(), n);
+        m_progress->bytesDone.fetchAndAddRelaxed(n);
+        off += n;
+    }
+    if (n < 0) return false;
+    if (d.size > off && !out.resize(off)) return false;
+    if (!out.flush()) return false;
+    bool timeSet = false;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    timeSet = out.setFileTime(QDateTime::fromMSecsSinceEpoch(src.mtimeMs), QFileDevice::FileModificationTime);
+#endif
+    out.close(); in.close();
+
+    // 新签名对应改写后的目标 stat（mtime 设置成功时即 off 与源 mtime，不必再 stat）；写不出来只是下次多读一遍目标
+    const FileStat nd = timeSet ? FileStat{true, true, off, src.mtimeMs, d.fileId} : statPath(dstPath);
+    fresh.fileSize = nd.size;
+    fresh.mtimeMs  = nd.mtimeMs;
+    if (!fresh.save(sigPath)) QFile::remove(sigPath);
+    QFile::remove(pendingPath);
+
+    if (srcHashOut) *srcHashOut = h.result();
+    if (srcSegmentsOut) *srcSegmentsOut = h.segments();
     return true;
 }
 
-bool BackupWorker::verifyFile(const QString& rel0) {
+BackupWorker::Verify BackupWorker::verifyFile(const QString& rel0, const QByteArray& expectedHash,
+                                              const QVector<QByteArray>& srcSegments) {
     const QString rel = cleanRel(rel0);
-    const QString srcPath = QDir(m_opt.srcDir).absoluteFilePath(rel);
+    const QString srcPath = srcAbsPath(rel);
     const QString dstPath = dstAbsPath(rel);
 
-    if (!isDestReadySameDevice()) return false;
-
-    QByteArray a = fileHashSha256(srcPath);
-    QByteArray b = fileHashSha256(dstPath);
-    if (a.isEmpty() || b.isEmpty()) return false;
-    if (a == b) return true;
+    if (!isDestReadySameDevice()) return Verify::Mismatch;
+
+    // 期望摘要来自复制时读到的源数据；缺失时才退回重读源。大文件两边都按段并行
+    QVector<QByteArray> srcSegs = expectedHash.isEmpty() ? QVector<QByteArray>() : srcSegments;
+    const QByteArray a = expectedHash.isEmpty() ? hashFile(srcPath, &srcSegs) : expectedHash;
+    QVector<QByteArray> dstSegs;
+    QByteArray b = hashFile(dstPath, &dstSegs);
+    if (a.isEmpty() || b.isEmpty()) return Verify::Mismatch;
+    if (a == b) return Verify::Ok;
+
+    // 多段文件：逐段比对定位坏段，只从源重写这些段，不再整文件重来
+    bool segmented = srcSegs.size() > 1 || dstSegs.size() > 1;
+    if (segmented && srcSegs.size() <= 1) {
+        srcSegs.clear();                                     // 调用方没给分段：补算一次
+        if (hashFile(srcPath, &srcSegs) != a) return Verify::SourceChanged; // 交给上层整文件重来
+        segmented = srcSegs.size() > 1;
+    }
 
     int delay = 1000;
     for (int i = 0; i < m_opt.maxRetries; ++i) {
-        QThread::msleep(delay);
-        if (!isDestReadySameDevice()) return false;
-        b = fileHashSha256(dstPath);
-        if (!b.isEmpty() && a == b) return true;
-        delay = qMin(delay * 2, 30000);
+        if (segmented) {
+            const Verify r = repairSegments(rel, srcSegs, &dstSegs);
+            if (r != Verify::Ok) return r;
+            b = TreeDigest::combine(m_opt.hashAlgo, dstSegs);
+        } else {
+            QThread::msleep(delay);
+            if (!isDestReadySameDevice()) return Verify::Mismatch;
+            b = hashFile(dstPath);
+            delay = qMin(delay * 2, 30000);
+        }
+        if (!b.isEmpty() && a == b) return Verify::Ok;
     }
-    return false;
+    return Verify::Mismatch;
+}
+
+// 源段先整段读入内存并与 srcSegments 核对：对不上说明源在复制后被改动，目标一个字节都不动，
+// 返回 SourceChanged 交给上层整文件重来；核对通过才写入目标同一偏移，再回读该段
+BackupWorker::Verify BackupWorker::repairSegments(const QString& rel, const QVector<QByteArray>& srcSegments,
+                                                  QVector<QByteArray>* dstSegments) {
+    const QString srcPath = srcAbsPath(rel);
+    const QString dstPath = dstAbsPath(rel);
+    const qint64 seg = TreeDigest::kSegment;
+
+    QFile in(srcPath), out(dstPath);
+    if (!in.open(QIODevice::ReadOnly)) return Verify::SourceChanged;
+    if (!out.open(QIODevice::ReadWrite)) return Verify::Mismatch;
+    const qint64 size = in.size();
+    if ((size + seg - 1) / seg != srcSegments.size()) return Verify::SourceChanged; // 源大小变了
+
+    const qint64 chunk = ioBufSize(seg);
+    QByteArray segBuf;                                      // 修复很少发生：按需分配一整段（≤ kSegment）
+    auto turn = [&]{
+        if (stopRequested()) return false;
+        while (m_pause.loadAcquire() && !stopRequested()) QThread::msleep(50);
+        return !stopRequested() && isDestReadySameDevice();
+    };
+    // 读 [off, off+len) 进 segBuf；读不满（文件被截短）返回 false
+    auto readSeg = [&](QFile& from, qint64 off, qint64 len) {
+        if (!from.seek(off)) return false;
+        for (qint64 got = 0; got < len; ) {
+            if (!turn()) return false;
+            const qint64 n = from.read(segBuf.data() + got, qMin(chunk, len - got));
+            if (n <= 0) return false;
+            got += n;
+        }
+        return true;
+    };
+    auto digestOf = [&](qint64 len) {
+        Digest d(m_opt.hashAlgo);
+        d.addData(segBuf.constData(), len);
+        return d.result();
+    };
+
+    dstSegments->resize(srcSegments.size());
+    int repaired = 0;
+    for (int i = 0; i < srcSegments.size(); ++i) {
+        if (dstSegments->at(i) == srcSegments.at(i)) continue;
+        const qint64 off = qint64(i) * seg;
+        const qint64 len = qMin(seg, size - off);
+        emit stateChanged(tr("修复第 %1/%2 段 · %3").arg(i + 1).arg(srcSegments.size()).arg(rel));
+        segBuf.resize(len);
+
+        if (!readSeg(in, off, len))                         // 停止/掉线之外读不满 = 源被截短
+            return stopRequested() || !isDestReadySameDevice() ? Verify::Mismatch : Verify::SourceChanged;
+        if (digestOf(len) != srcSegments.at(i)) return Verify::SourceChanged;
+
+        if (!out.seek(off)) return Verify::Mismatch;
+        for (qint64 put = 0; put < len; ) {
+            if (!turn()) return Verify::Mismatch;
+            const qint64 n = qMin(chunk, len - put);
+            m_limiter.consume(n, [this]{ return stopRequested(); });
+            if (out.write(segBuf.constData() + put, n) != n) return Verify::Mismatch;
+            put += n;
+        }
+        if (!out.flush()) return Verify::Mismatch;
+
+        if (!readSeg(out, off, len)) return Verify::Mismatch;
+        (*dstSegments)[i] = digestOf(len);
+        ++repaired;
+    }
+    if (out.size() != size && !out.resize(size)) return Verify::Mismatch;
+
+    // 原地改写动了目标 mtime：恢复为源 mtime（取自已打开的源，不再按路径 stat），索引的“目标摘要可信”判断依赖它
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    if (repaired > 0)
+        out.setFileTime(in.fileTime(QFileDevice::FileModificationTime), QFileDevice::FileModificationTime);
+#endif
+    out.close(); in.close();
+    return Verify::Ok;
 }
 
 void BackupWorker::requestPause(bool p) { m_pause.storeRelease(p ? 1 : 0); }
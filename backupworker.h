@@ -1,20 +1,51 @@
 #pragma once
 #include <QObject>
 #include <QAtomicInt>
+#include <QMutex>
 #include <QString>
 #include <QStringList>
 #include <QByteArray>
+#include <functional>
+#include <memory>
+
+#include "fileindex.h"
+#include "RateLimiter.h"
+#include "chunkstore.h"
+#include "blocksignature.h"
+#include "BufferPool.h"
+#include "BackupProgress.h"
+#include "digest.h"
+#include "PathTable.h"
+#include "RetentionPolicy.h"
+#include "DirStatCache.h"
+#include "devicemonitor.h"
+#include "vaultcatalog.h"
+
+class QThread;
+class QFile;
 
 /**
  * 单个“源目录 → 目标目录”的备份任务
  * - 命名空间隔离：dst/<nsPrefix()>/rel/path，避免多源同名覆盖
  * - 快速校验：size/mtime 快速判断，仅在可能相同的情况下才哈希
- * - 写后校验（可配）、失败重试、限速、忽略/白名单
- * - 历史版本与删除留存（带保留天数）
+ * - 持久化索引：源 stat 与上次成功备份一致即跳过（不读目标）
+ * - 写后校验（可配）：源摘要在复制时一次读出，校验只回读目标；失败重试、限速、忽略/白名单
+ * - 摘要算法可选（SHA-256 / BLAKE3 / XXH3-128，见 digest.h），记入索引与留存元数据
+ * - Linux 内核侧复制：同盘 reflink（FICLONE）；关闭写后校验时用 copy_file_range，数据不经用户态
+ * - Linux 异步读写：大文件经 io_uring 让多个读/写同时在途，源盘与目标盘并行工作
+ * - 其他情况下大文件由读线程预读（无锁环形队列传缓冲），读源与写目标同样重叠
+ * - 增量运行：只扫描监听到改动的目录（scopeDirs/scopeTrees），删除判定随之限定在范围内
+ * - 流水线：扫描线程边遍历边投递到有界队列，复制不必等全量扫描结束
+ * - 并行复制：多个复制通道共享限速预算、暂停/停止与离线等待
+ * - 增量复制（可选）：大文件按块比对目标签名，只原地改写变化的块
+ * - 进度经 BackupProgress 原子计数交给观察方定时读取；逐个送达的只有失败项与留存事件
+ * - 历史版本与删除留存（保留天数/每文件版本数/按时稀疏，在留存区目录上评估）；可选分块去重存储（只写新块）；留存区目录（vault.cat）随归档/清理追加
  * - 安全：目标设备指纹校验；离线等待；发离线/恢复信号；绝不误写
  */
 class BackupWorker : public QObject {
     Q_OBJECT
+    friend class BackupBench; // bench/：直接测量扫描/复制/校验/删除等内部热点
+    friend class BackupWorkerTest; // tests/：回归测试直接调用复制/校验等内部步骤
 public:
     struct Options {
         QString srcDir;                  // 源目录
@@ -23,39 +54,64 @@ public:
         int     maxRetries       = 3;
         QStringList ignoreGlobs;         // 忽略（glob）
         QStringList filesWhitelist;      // 相对路径白名单，空=全量
-        qint64  speedLimitBps    = 0;    // 限速 B/s（0 不限）
+        qint64  speedLimitBps    = 0;    // 限速 B/s（0 不限，所有复制通道共享）
 
         // 版本/删除留存
         bool    keepVersionsOnChange = true;
         bool    keepDeletedInVault   = true;
         int     retentionDays        = 7;
+        bool    chunkStoreVault      = false; // 版本/删除项存为块清单（.plugbackup_meta/chunks 共享块）
 
         // 可选：自定义命名空间名（留空则自动生成）
         QString nsName;
+
+        // 并行复制通道数（≥1）；小文件多时可把逐文件的打开/建目录/改名开销重叠起来
+        int     copyLanes = 1;
+
+        // 增量复制：目标已有旧内容的大文件只改写变化的块（减少对 U 盘的写入量与磨损）
+        // 开启历史版本且未用分块存储时，旧文件会被整体移走，此时没有可比对的目标，仍走整文件复制
+        bool    deltaTransfer = false;
+
+        // 增量运行范围（相对 srcDir；"" = 根目录本层），两者皆空 = 全量
+        // 只扫描这些目录，删除判定也只在范围内进行；由文件监听的脏路径日志给出
+        QStringList scopeDirs;           // 只看这一层
+        QStringList scopeTrees;          // 整棵（新出现的目录）
+
+        // 内容摘要算法：复制时的源摘要、写后校验、索引比对都用它；本次构建不支持时退回 SHA-256
+        Digest::Algo hashAlgo = Digest::Algo::Sha256;
+
+        // 留存策略（与 retentionDays 同时生效，见 RetentionPolicy）：0 = 不启用该条
+        int     keepVersions = 0;        // 每个文件最多保留的版本数
+        int     keepHourly   = 0;        // 稀疏：最近 N 个有版本的小时各留最新一份
+        int     keepDaily    = 0;        //       最近 N 个有版本的天
+        int     keepWeekly   = 0;        //       最近 N 个有版本的周
+
+        // 删除保护：一轮里源中不见的文件过多（源盘没挂好、目录被整体移走）时暂缓移走，发 deletionsHeld 等确认
+        bool    allowMassDeletion = false; // true = 已确认，照常移入删除留存
     };
 
     explicit BackupWorker(Options opt, QObject* parent=nullptr);
 
+    // 进度快照来源（任意线程读取；比 worker 活得久，可在 finished 之后取最终值）
+    std::shared_ptr<BackupProgress> progress() const { return m_progress; }
+
 public slots:
     void run();                 // 放入 QThread 后开始
     void requestPause(bool p);  // 暂停/继续
     void requestStop();         // 取消
 
 signals:
-    // 任务级
-    void progressUpdated(qint64 bytesDone, qint64 bytesTotal);
-    void speedUpdated(double bytesPerSec);
-    void etaUpdated(qint64 secondsLeft);
+    // 任务级（字节/文件数/速率/ETA 不发信号，见 progress()）
     void stateChanged(const QString& stateText);
     void finished(bool ok, const QString& summary);
 
-    // 文件级
-    void fileStarted(const QString& relPath, qint64 size);
-    void fileFinished(const QString& relPath, bool ok, const QString& err);
+    // 文件级：只报失败（成功/跳过只计数）
+    void fileFailed(const QString& relPath, const QString& err);
 
     // 版本/删除留存
     void versionCreated(const QString& rel, const QString& versionFilePath, const QString& metaPath);
     void deletedStashed(const QString& rel, const QString& deletedFilePath, const QString& metaPath);
+    void deletionsHeld(int count);   // 删除项过多，本轮没有移走（见 Options::allowMassDeletion）
 
     // 设备事件（状态切换才发一次）
     void deviceOffline(const QString& phaseHint);
@@ -65,21 +121,51 @@ private:
     // 主流程
     qint64 calcTotalBytes() const;
     QStringList listAllFiles() const;
+    bool scanSource(const std::function<bool(const QString& rel, const FileStat& st)>& visit) const; // 流式遍历源（带遍历时的 stat）
     bool shouldSkip(const QString& rel) const;
-    bool copyOneFile(const QString& rel, qint64* bytesDone); // .part→rename
-    bool verifyFile(const QString& rel);
+    bool isScopedRun() const;                              // 只处理 scopeDirs/scopeTrees
+    void processFile(const QString& rel, const FileStat& st); // 单文件：跳过/版本化/复制/校验（可并行调用）；st 为扫描时的源 stat
+    bool copyOneFile(const QString& rel, const FileStat& src, const FileStat& dst, // .part→rename，边拷边算源摘要
+                     QByteArray* srcHashOut,
+                     QVector<QByteArray>* srcSegmentsOut = nullptr);   // 分段摘要（TreeDigest）
+    enum class Verify { Ok, Mismatch, SourceChanged };                 // SourceChanged：源在复制后被改动，应整文件重来
+    Verify verifyFile(const QString& rel, const QByteArray& expectedHash, // 只回读目标；大文件按段并行
+                      const QVector<QByteArray>& srcSegments = {});       // 不一致时只重写坏段
+    Verify repairSegments(const QString& rel, const QVector<QByteArray>& srcSegments,
+                          QVector<QByteArray>* dstSegments);              // 从源重写摘要不同的段并回读
+    bool copyDeltaInPlace(const QString& rel, const FileStat& src, const FileStat& dst, // 按块比对，原地改写变化的块
+                          QByteArray* srcHashOut, QVector<QByteArray>* srcSegmentsOut = nullptr);
+    bool copyPipelined(QFile& in, QFile& out, TreeDigest* h);           // 读线程 + 写线程，双缓冲以上重叠
+#ifdef Q_OS_LINUX
+    enum class KernelCopy { Done, Failed, Unsupported };
+    KernelCopy copyKernelSide(QFile& in, QFile& out, bool allowCopyRange); // FICLONE / copy_file_range
+    KernelCopy copyIoUring(QFile& in, QFile& out, TreeDigest* h);         // 多个读写同时在途，顺带算源摘要
+#endif
 
     // 版本与删除留存
-    bool maybeStashExistingVersion(const QString& rel);
-    void handleDeletions(const QSet<QString>& srcSet);
-    void sweepRetention();
+    bool maybeStashExistingVersion(const QString& rel, FileStat* dst); // 归档后更新 *dst（移走 → 不存在）
+    void handleDeletions(const PathTable& srcSet, bool scanComplete); // 扫描不完整时什么也不删
+    bool stashDeleted(const QString& rel, const FileStat& dst); // 删除项移入留存区，成功后剔除索引记录
+    void catalogAdd(VaultCatalog::Kind kind, const QString& rel, const QString& ts,
+                    const QString& payload, qint64 size, const QByteArray& digest);
+    void sweepRetention();                                 // 按目录评估留存策略，只删到期项
+    RetentionPolicy retentionPolicy() const;
+    QString retentionStatePath() const;                    // dst/.plugbackup_meta/index/<ns>/retention.json
 
     // 安全：目标设备就绪/同一设备检测 + 等待
-    bool isDestReadySameDevice() const;
+    bool isDestReadySameDevice() const;                    // 读监视器的标志（热路径）
+    bool recheckDestReady();                               // I/O 出错后立即复核，不等后台线程
     void waitUntilDestReadyOrStopped(const QString& phaseHint = QString());
+    bool stopRequested() const;                            // m_stop 或所属线程被请求中断
 
     // 辅助
-    static QByteArray fileHashSha256(const QString& path);
+    static QByteArray fileHash(const QString& path, Digest::Algo algo = Digest::Algo::Sha256,
+                               BufferPool* pool = nullptr, double bytesPerSec = 0, int threads = 1,
+                               QVector<QByteArray>* segmentsOut = nullptr,
+                               const std::function<bool()>& cancelled = {}); // TreeDigest 形式，多段时并行
+    QByteArray hashFile(const QString& path, QVector<QByteArray>* segmentsOut = nullptr) const; // 本任务的算法/缓冲池/线程数
+    int hashThreads() const;                               // 单个复制通道可用的摘要线程数
+    qint64 ioBufSize(qint64 fileSize) const;               // 按文件大小与单通道实测吞吐选缓冲
     static bool ensureDir(const QString& dirPath);
     static bool moveFileRobust(const QString& from, const QString& to);
     static QString tsNow();
@@ -87,6 +173,7 @@ private:
     // 命名空间 & 路径
     QString nsPrefix() const;                              // e.g. "Photos_7a1c3bde"
     QString nsSubRoot() const;                             // dst/<ns>/
+    QString srcAbsPath(const QString& rel) const;          // src/<rel>
     QString dstAbsPath(const QString& rel) const;          // dst/<ns>/<rel>
     QString metaRoot() const;                              // dst/.plugbackup_meta
     QString versionsRoot() const;                          // dst/.plugbackup_meta/versions
@@ -94,22 +181,60 @@ private:
     QString versionFilePath(const QString& rel, const QString& ts) const; // versions/<ns>/<rel>.vTS
     QString deletedFilePath(const QString& rel, const QString& ts) const; // deleted/<ns>/<rel>.dTS
     QString writeMetaJson(const QString& payloadPath, const QString& rel,
-                          const QString& kind, const QString& ts) const;
+                          const QString& kind, const QString& ts,
+                          const QByteArray& digest = QByteArray()) const; // digest：归档内容的摘要（已知时）
+
+    QString indexFilePath() const;                         // dst/.plugbackup_meta/index/<ns>/files.idx
+    QString chunksRoot() const;                            // dst/.plugbackup_meta/chunks
+    QString stashToVault(const QString& fromAbs, const QString& outPath, bool keepOriginal); // 移动或切块入库，返回归档路径
+    QString deltaSigPath(const QString& rel) const;        // dst/.plugbackup_meta/index/<ns>/sig/<sha1>.sig
+    bool    deltaPending(const QString& rel) const;        // 上次增量改写未完成（目标内容新旧混杂）
+    void    dropDeltaState(const QString& rel) const;      // 删除签名与未完成标记
 
     // 快速相等判断（减少哈希开销）
-    bool likelySameByStat(const QString& srcAbs, const QString& dstAbs) const;
+    static bool likelySameByStat(const FileStat& src, const FileStat& dst);
+    QByteArray dstHashFromIndex(const QString& rel, const FileStat& dst) const;
+    bool sameContentAsDest(const QString& rel, const QString& srcAbs, const QString& dstAbs,
+                           const FileStat& src, const FileStat& dst, QByteArray* srcHashOut);
 
 private:
     Options    m_opt;
     QAtomicInt m_pause{0}, m_stop{0};
-    qint64     m_totalBytes = 0;
 
-    // 设备指纹：首次 run() 记录
-    QByteArray m_expectedDevice;
+    // 进度计数（字节/文件数/速率）：扫描线程与复制通道只做原子累加，观察方定时取快照
+    std::shared_ptr<BackupProgress> m_progress = std::make_shared<BackupProgress>();
 
-    // 防抖：离线提示仅一次
+    // 目标侧 stat 快照：run() 开始时新建，按目录成批取得
+    std::unique_ptr<DirStatCache> m_dstStats;
+
+    // 持久化文件索引：run() 开始时载入，结束时保存；复制通道并发访问需加锁
+    FileIndex  m_index;
+    mutable QMutex m_indexMutex;
+
+    // 留存区目录：归档/清理时追加记录，界面列举只读这一个文件
+    std::unique_ptr<VaultCatalog> m_catalog;
+
+    // 分块仓库（chunkStoreVault 时使用；同一目标盘上所有命名空间共享）
+    ChunkStore m_chunks;
+
+    // 并行复制共享状态
+    RateLimiter m_limiter;
+    mutable BufferPool m_bufPool;                          // 复制/哈希缓冲复用，不再每个文件分配
+    QAtomicInteger<qint64> m_laneBps{0};                   // 单个复制通道的近期吞吐（run() 汇总时更新）
+    QThread*    m_runThread = nullptr;                     // 执行 run() 的线程（用于中断检测）
+    int         m_deletionsHeld = 0;                       // 本轮暂缓移走的删除项数（仅 run() 线程读写）
+
+    // 目标设备监视：run() 期间后台线程维护就绪标志（设备指纹在 start() 时记录）
+    mutable DeviceMonitor m_device;
+
+    // 防抖：离线提示仅一次（多个复制通道共用）
     bool       m_offlineSignaled = false;
+    QMutex     m_offlineMutex;
 
     // 缓存自动生成的 ns
     mutable QString m_cachedNs;
+
+    // 构造时算好的绝对根：src/ 与 dst/<ns>/
+    QString m_srcRootAbs;
+    QString m_nsRootAbs;
 };
@@ -0,0 +1,367 @@
+#include "backupworker.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+
+#include <functional>
+
+#ifdef Q_OS_LINUX
+#include <sys/resource.h>
+#endif
+
+/**
+ * plugbackup_bench：无界面基准测试
+ * - 在临时目录合成目录树：small（大量小文件）/ huge（少量大文件）/ deep（深层级）/ mixed（混合）
+ * - 分阶段测量：scan / hash / copy / verify / run_full / run_noop / deletions
+ * - 每阶段输出：耗时、files/s、MB/s、读写系统调用数与字节数（/proc/self/io）、峰值 RSS
+ * - 结果为 JSON（--out 写文件，否则打印到标准输出），便于跨版本比对
+ * 注意：刚生成的文件大多仍在页缓存里，读路径数字反映的是“热缓存”情况。
+ */
+
+// 友元：直接调用 BackupWorker 内部热点
+class BackupBench {
+public:
+    static QStringList listAllFiles(const BackupWorker& w)  { return w.listAllFiles(); }
+    static QByteArray  fileHash(const QString& path, Digest::Algo a) {
+        return BackupWorker::fileHash(path, a, nullptr, 0, QThread::idealThreadCount());
+    }
+    static bool copyOneFile(BackupWorker& w, const QString& rel, QByteArray* hash) {
+        return w.copyOneFile(rel, statPath(w.srcAbsPath(rel)), statPath(w.dstAbsPath(rel)), hash);
+    }
+    static bool verifyFile(BackupWorker& w, const QString& rel, const QByteArray& hash) { return w.verifyFile(rel, hash) == BackupWorker::Verify::Ok; }
+    static void startDevice(BackupWorker& w)                                             { w.m_device.start(); }
+    static void stopDevice(BackupWorker& w)                                              { w.m_device.stop(); }
+    static void loadIndex(BackupWorker& w)                                               { w.m_index = FileIndex(w.indexFilePath()); w.m_index.load(); }
+    static void handleDeletions(BackupWorker& w, const PathTable& srcSet)               { w.handleDeletions(srcSet, true); }
+};
+
+namespace {
+
+// 与 run() 一致：后台监视目标设备，复制/校验循环里的就绪检查只读标志（不然每次都走同步的挂载表检查）
+struct DeviceScope {
+    BackupWorker& w;
+    explicit DeviceScope(BackupWorker& worker) : w(worker) { BackupBench::startDevice(w); }
+    ~DeviceScope() { BackupBench::stopDevice(w); }
+};
+
+struct ProcIo { qint64 rchar = 0, wchar = 0, syscr = 0, syscw = 0, readBytes = 0, writeBytes = 0; };
+
+ProcIo readProcIo() {
+    ProcIo io;
+#ifdef Q_OS_LINUX
+    QFile f("/proc/self/io");
+    if (!f.open(QIODevice::ReadOnly)) return io;
+    for (const QByteArray& line : f.readAll().split('\n')) {
+        const int colon = int(line.indexOf(':'));
+        if (colon < 0) continue;
+        const QByteArray key = line.left(colon);
+        const qint64 v = line.mid(colon + 1).trimmed().toLongLong();
+        if      (key == "rchar")       io.rchar      = v;
+        else if (key == "wchar")       io.wchar      = v;
+        else if (key == "syscr")       io.syscr      = v;
+        else if (key == "syscw")       io.syscw      = v;
+        else if (key == "read_bytes")  io.readBytes  = v;
+        else if (key == "write_bytes") io.writeBytes = v;
+    }
+#endif
+    return io;
+}
+
+// 每阶段前重置峰值 RSS（Linux ≥ 4.0：clear_refs 写 5），阶段后读 VmHWM；
+// 读不到时退回进程级峰值（getrusage），其它平台为 -1
+void resetPeakRss() {
+#ifdef Q_OS_LINUX
+    QFile f("/proc/self/clear_refs");
+    if (f.open(QIODevice::WriteOnly)) f.write("5");
+#endif
+}
+
+qint64 peakRssKb() {
+#ifdef Q_OS_LINUX
+    QFile f("/proc/self/status");
+    if (f.open(QIODevice::ReadOnly)) {
+        for (const QByteArray& line : f.readAll().split('\n'))
+            if (line.startsWith("VmHWM:")) return line.mid(6).trimmed().split(' ').value(0).toLongLong();
+    }
+    struct rusage ru{};
+    if (getrusage(RUSAGE_SELF, &ru) == 0) return ru.ru_maxrss;
+#endif
+    return -1;
+}
+
+struct Work { qint64 files = 0, bytes = 0; };
+
+QJsonObject measure(const QString& phase, const std::function<Work()>& fn) {
+    resetPeakRss();
+    const ProcIo a = readProcIo();
+    QElapsedTimer t; t.start();
+    const Work w = fn();
+    const qint64 ns = t.nsecsElapsed();
+    const ProcIo b = readProcIo();
+    const double sec = qMax(1e-9, double(ns) / 1e9);
+
+    QTextStream(stderr) << "  " << phase << ": " << QString::number(double(ns) / 1e6, 'f', 1) << " ms\n";
+    return QJsonObject{
+        {"phase",          phase},
+        {"ms",             double(ns) / 1e6},
+        {"files",          w.files},
+        {"bytes",          w.bytes},
+        {"files_per_s",    double(w.files) / sec},
+        {"mb_per_s",       double(w.bytes) / sec / (1024.0 * 1024.0)},
+        {"syscalls_read",  b.syscr - a.syscr},
+        {"syscalls_write", b.syscw - a.syscw},
+        {"rchar",          b.rchar - a.rchar},
+        {"wchar",          b.wchar - a.wchar},
+        {"read_bytes",     b.readBytes - a.readBytes},
+        {"write_bytes",    b.writeBytes - a.writeBytes},
+        {"peak_rss_kb",    peakRssKb()}
+    };
+}
+
+struct FileSpec { QString rel; qint64 size = 0; };
+struct Scenario { QString name; QList<FileSpec> files; };
+
+Scenario makeScenario(const QString& name, double scale) {
+    Scenario s{name, {}};
+    auto n = [&](int base){ return qMax(1, int(base * scale)); };
+    QRandomGenerator rng(42);
+    if (name == "small") {
+        for (int i = 0; i < n(20000); ++i)
+            s.files.push_back({QString("d%1/f%2.txt").arg(i % 200).arg(i), 4 * 1024});
+    } else if (name == "huge") {
+        for (int i = 0; i < 4; ++i)
+            s.files.push_back({QString("big%1.bin").arg(i), qint64(n(256)) * 1024 * 1024});
+    } else if (name == "deep") {
+        QString dir;
+        for (int d = 0; d < 48; ++d) {
+            dir += QString("level%1/").arg(d);
+            for (int i = 0; i < n(50); ++i)
+                s.files.push_back({dir + QString("f%1.dat").arg(i), 16 * 1024});
+        }
+    } else { // mixed
+        for (int i = 0; i < n(5000); ++i)
+            s.files.push_back({QString("src/m%1/s%2.c").arg(i % 64).arg(i), 1024 + qint64(rng.bounded(64 * 1024))});
+        for (int i = 0; i < n(200); ++i)
+            s.files.push_back({QString("docs/d%1.pdf").arg(i), (1 + qint64(rng.bounded(8))) * 1024 * 1024});
+        for (int i = 0; i < 2; ++i)
+            s.files.push_back({QString("vm/disk%1.img").arg(i), qint64(n(64)) * 1024 * 1024});
+    }
+    return s;
+}
+
+// 用一段随机数据按不同起点循环填充，生成速度快且文件内容各不相同
+bool generateTree(const QString& root, const Scenario& s) {
+    const int PATTERN = 4 << 20;
+    QByteArray pattern(PATTERN, Qt::Uninitialized);
+    QRandomGenerator rng(7);
+    rng.fillRange(reinterpret_cast<quint32*>(pattern.data()), PATTERN / 4);
+
+    for (const FileSpec& f : s.files) {
+        const QString abs = QDir(root).absoluteFilePath(f.rel);
+        QDir().mkpath(QFileInfo(abs).absolutePath());
+        QFile out(abs);
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+        qint64 left = f.size;
+        int off = int(rng.bounded(PATTERN));
+        while (left > 0) {
+            const qint64 n = qMin<qint64>(left, PATTERN - off);
+            if (out.write(pattern.constData() + off, n) != n) return false;
+            left -= n;
+            off = 0;
+        }
+    }
+    return true;
+}
+
+QJsonObject runScenario(const Scenario& sc, const QString& base, bool verify, int lanes, Digest::Algo algo) {
+    const QString src     = QDir(base).absoluteFilePath("src");
+    const QString dstCopy = QDir(base).absoluteFilePath("dst_copy");
+    const QString dstRun  = QDir(base).absoluteFilePath("dst_run");
+
+    QTextStream(stderr) << sc.name << ": " << sc.files.size() << " files\n";
+    QElapsedTimer gen; gen.start();
+    if (!generateTree(src, sc)) return QJsonObject{{"name", sc.name}, {"error", "generate failed"}};
+    const qint64 genMs = gen.elapsed();
+
+    QHash<QString, qint64> sizes;
+    qint64 totalBytes = 0;
+    for (const FileSpec& f : sc.files) { sizes.insert(f.rel, f.size); totalBytes += f.size; }
+
+    BackupWorker::Options o;
+    o.srcDir = src;
+    o.dstDir = dstCopy;
+    o.verifyAfterWrite = verify;
+    o.nsName = QStringLiteral("bench");
+    o.copyLanes = lanes;
+    o.hashAlgo = algo;
+    QDir().mkpath(dstCopy);                                 // 监视的是目标目录本身：须先存在
+    BackupWorker w(o);
+    DeviceScope wDevice(w);
+
+    QJsonArray phases;
+    QStringList rels;
+    QHash<QString, QByteArray> hashes;
+
+    phases.append(measure("scan", [&]{
+        rels = BackupBench::listAllFiles(w);
+        return Work{rels.size(), 0};
+    }));
+    phases.append(measure("hash", [&]{
+        Work r;
+        for (const QString& rel : rels) {
+            BackupBench::fileHash(QDir(src).absoluteFilePath(rel), algo);
+            ++r.files; r.bytes += sizes.value(rel);
+        }
+        return r;
+    }));
+    phases.append(measure("copy", [&]{
+        Work r;
+        for (const QString& rel : rels) {
+            QByteArray h;
+            if (!BackupBench::copyOneFile(w, rel, &h)) continue;
+            hashes.insert(rel, h);
+            ++r.files; r.bytes += sizes.value(rel);
+        }
+        return r;
+    }));
+    if (verify) {
+        phases.append(measure("verify", [&]{
+            Work r;
+            for (const QString& rel : rels) {
+                if (!BackupBench::verifyFile(w, rel, hashes.value(rel))) continue;
+                ++r.files; r.bytes += sizes.value(rel);
+            }
+            return r;
+        }));
+    }
+
+    // 整轮 run()：首轮全量；第二轮无改动（索引命中）
+    BackupWorker::Options ro = o;
+    ro.dstDir = dstRun;
+    {
+        BackupWorker r(ro);
+        phases.append(measure("run_full", [&]{ r.run(); return Work{rels.size(), totalBytes}; }));
+    }
+    {
+        BackupWorker r(ro);
+        phases.append(measure("run_noop", [&]{ r.run(); return Work{rels.size(), 0}; }));
+    }
+
+    // 删除处理：删掉约 10% 源文件后对 dst_run 做一次删除留存
+    PathTable keep;
+    qint64 removed = 0;
+    for (int i = 0; i < rels.size(); ++i) {
+        if (i % 10 == 0 && QFile::remove(QDir(src).absoluteFilePath(rels.at(i)))) ++removed;
+        else keep.insert(rels.at(i));
+    }
+    {
+        BackupWorker d(ro);
+        DeviceScope dDevice(d);
+        BackupBench::loadIndex(d);                          // 与 run() 一致：有目标清单时走清单比对
+        phases.append(measure("deletions", [&]{
+            BackupBench::handleDeletions(d, keep);
+            return Work{removed, 0};
+        }));
+    }
+
+    return QJsonObject{
+        {"name",        sc.name},
+        {"files",       qint64(sc.files.size())},
+        {"bytes",       totalBytes},
+        {"generate_ms", genMs},
+        {"phases",      phases}
+    };
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("plugbackup_bench");
+
+    QCommandLineParser p;
+    p.setApplicationDescription("PlugBackup benchmark harness (scan/hash/copy/verify/run/deletions)");
+    p.addHelpOption();
+    const QCommandLineOption optScenario("scenario", "small|huge|deep|mixed|all", "name", "all");
+    const QCommandLineOption optScale("scale", "Scale factor for file counts/sizes", "factor", "1.0");
+    const QCommandLineOption optRoot("root", "Directory for synthetic trees (default: system temp)", "dir");
+    const QCommandLineOption optOut("out", "Write JSON result to file instead of stdout", "file");
+    const QCommandLineOption optLanes("lanes", "Copy lanes for run_* phases", "n", "1");
+    const QCommandLineOption optNoVerify("no-verify", "Disable verify-after-write");
+    const QCommandLineOption optHash("hash", "Digest for hash/copy/verify phases: sha256|blake3|xxh128", "algo", "sha256");
+    p.addOptions({optScenario, optScale, optRoot, optOut, optLanes, optNoVerify, optHash});
+    p.process(app);
+
+    const double scale  = qMax(0.001, p.value(optScale).toDouble());
+    const bool   verify = !p.isSet(optNoVerify);
+    const int    lanes  = qMax(1, p.value(optLanes).toInt());
+    Digest::Algo algo = Digest::Algo::Sha256;
+    if (!Digest::fromName(p.value(optHash), &algo)) {
+        QTextStream(stderr) << "unknown hash: " << p.value(optHash) << "\n";
+        return 2;
+    }
+    if (!Digest::available(algo))
+        QTextStream(stderr) << p.value(optHash) << " not built in, falling back to sha256\n";
+    algo = Digest::effective(algo);
+
+    QStringList names = {"small", "huge", "deep", "mixed"};
+    if (p.value(optScenario) != "all") {
+        if (!names.contains(p.value(optScenario))) {
+            QTextStream(stderr) << "unknown scenario: " << p.value(optScenario) << "\n";
+            return 2;
+        }
+        names = {p.value(optScenario)};
+    }
+
+    const QString rootDir = p.isSet(optRoot) ? p.value(optRoot) : QDir::tempPath();
+    QDir().mkpath(rootDir);
+    QTemporaryDir tmp(QDir(rootDir).absoluteFilePath("plugbackup_bench-XXXXXX"));
+    if (!tmp.isValid()) {
+        QTextStream(stderr) << "cannot create temp dir under " << rootDir << "\n";
+        return 2;
+    }
+
+    QJsonArray scenarios;
+    for (const QString& name : names) {
+        const QString base = QDir(tmp.path()).absoluteFilePath(name);
+        scenarios.append(runScenario(makeScenario(name, scale), base, verify, lanes, algo));
+        QDir(base).removeRecursively(); // 逐个清理，避免临时盘被占满
+    }
+
+    const QJsonObject result{
+        {"tool",      "plugbackup_bench"},
+        {"qt",        QString::fromLatin1(qVersion())},
+        {"timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate)},
+        {"scale",     scale},
+        {"verify",    verify},
+        {"lanes",     lanes},
+        {"hash",      Digest::backend(algo)},
+        {"root",      rootDir},
+        {"scenarios", scenarios}
+    };
+    const QByteArray json = QJsonDocument(result).toJson(QJsonDocument::Indented);
+
+    if (p.isSet(optOut)) {
+        QFile f(p.value(optOut));
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate) || f.write(json) != json.size()) {
+            QTextStream(stderr) << "cannot write " << p.value(optOut) << "\n";
+            return 1;
+        }
+    } else {
+        QTextStream(stdout) << json;
+    }
+    return 0;
+}
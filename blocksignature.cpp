@@ -0,0 +1,50 @@
+#include "blocksignature.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QCryptographicHash>
+
+static const quint32 kSigMagic   = 0x50425347; // "PBSG"
+static const quint32 kSigVersion = 1;
+
+bool BlockSignature::load(const QString& path) {
+    m_digests.clear();
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    QDataStream in(&f);
+    in.setVersion(QDataStream::Qt_5_15);
+
+    quint32 magic = 0, ver = 0;
+    qint32 bs = 0;
+    in >> magic >> ver >> fileSize >> mtimeMs >> bs >> m_digests;
+    if (in.status() != QDataStream::Ok || magic != kSigMagic || ver != kSigVersion
+        || m_digests.size() % kDigestLen != 0) {
+        m_digests.clear();
+        return false;
+    }
+    blockSize = bs;
+    return true;
+}
+
+bool BlockSignature::save(const QString& path) const {
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    QDataStream out(&f);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << kSigMagic << kSigVersion << fileSize << mtimeMs << qint32(blockSize) << m_digests;
+    return out.status() == QDataStream::Ok && f.commit();
+}
+
+QByteArray BlockSignature::blockDigest(const char* data, qint64 n) {
+    QCryptographicHash h(QCryptographicHash::Sha256);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    h.addData(QByteArrayView(data, static_cast<qsizetype>(n)));
+#else
+    h.addData(data, int(n));
+#endif
+    return h.result();
+}
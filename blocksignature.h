@@ -0,0 +1,31 @@
+#pragma once
+#include <QString>
+#include <QByteArray>
+
+/**
+ * @brief 目标文件的分块签名（增量复制用）
+ * 路径：dst/.plugbackup_meta/index/<ns>/sig/<sha1(rel)>.sig
+ * 按固定块长切分，每块记 SHA-256；头部记录生成签名时目标文件的 size/mtime，
+ * 与目标当前 stat 不一致即视为失效（退回逐块回读目标比对）。
+ */
+class BlockSignature {
+public:
+    static constexpr int kBlockSize = 64 * 1024;
+    static constexpr int kDigestLen = 32;
+
+    qint64     fileSize  = 0;
+    qint64     mtimeMs   = 0;
+    int        blockSize = kBlockSize;
+
+    int        blockCount() const { return int(m_digests.size() / kDigestLen); }
+    QByteArray digestAt(int i) const { return m_digests.mid(qsizetype(i) * kDigestLen, kDigestLen); }
+    void       append(const QByteArray& digest) { m_digests += digest; }
+
+    bool load(const QString& path);        // 不存在/损坏 → false
+    bool save(const QString& path) const;  // QSaveFile 原子写入
+
+    static QByteArray blockDigest(const char* data, qint64 n);
+
+private:
+    QByteArray m_digests;                  // 每块 kDigestLen 字节，顺序拼接
+};
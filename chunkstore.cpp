@@ -0,0 +1,206 @@
+#include "chunkstore.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QCryptographicHash>
+#include <QReadWriteLock>
+
+#include <cstring>
+#include <utility>
+
+namespace {
+
+// FastCDC 参数：最小/平均/最大块长
+constexpr int kMinChunk = 16 * 1024;
+constexpr int kAvgChunk = 64 * 1024;
+constexpr int kMaxChunk = 256 * 1024;
+
+// 归一化分块：平均长度之前用更严格的掩码（难切），之后用更宽松的掩码（易切）
+constexpr quint64 kMaskS = ~quint64(0) << (64 - 18);
+constexpr quint64 kMaskL = ~quint64(0) << (64 - 14);
+
+// gear 表：固定种子的 splitmix64 序列，保证不同机器/版本切分一致
+struct GearTable {
+    quint64 v[256];
+    GearTable() {
+        quint64 x = 0x9E3779B97F4A7C15ull;
+        for (quint64& g : v) {
+            x += 0x9E3779B97F4A7C15ull;
+            quint64 z = x;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            g = z ^ (z >> 31);
+        }
+    }
+};
+const quint64* gear() { static const GearTable t; return t.v; }
+
+// 在 p[0, len) 中找切分点（len 不足最大块时调用方须保证已到文件尾）
+int cutPoint(const uchar* p, int len) {
+    if (len <= kMinChunk) return len;
+    const int n      = qMin(len, kMaxChunk);
+    const int normal = qMin(n, kAvgChunk);
+    const quint64* g = gear();
+    quint64 fp = 0;
+    int i = kMinChunk;
+    for (; i < normal; ++i) { fp = (fp << 1) + g[p[i]]; if (!(fp & kMaskS)) return i + 1; }
+    for (; i < n; ++i)      { fp = (fp << 1) + g[p[i]]; if (!(fp & kMaskL)) return i + 1; }
+    return n;
+}
+
+// 同进程内：入库（读锁，可并发）与垃圾回收（写锁，独占）互斥，
+// 避免回收时删掉“刚复用、清单尚未写出”的块
+QReadWriteLock& gcLock() { static QReadWriteLock l; return l; }
+
+struct ManifestChunk { QByteArray id; qint64 len = 0; };
+
+bool readManifest(const QString& path, qint64* totalSize, QByteArray* wholeHex, QList<ManifestChunk>* chunks) {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    if (f.readLine().trimmed() != "PBCM 1") return false;
+    while (!f.atEnd()) {
+        const QByteArray line = f.readLine().trimmed();
+        if (line.isEmpty()) continue;
+        const int sp = int(line.indexOf(' '));
+        if (sp <= 0) return false;
+        const QByteArray key = line.left(sp), val = line.mid(sp + 1);
+        if (key == "size")        { if (totalSize) *totalSize = val.toLongLong(); }
+        else if (key == "sha256") { if (wholeHex) *wholeHex = val; }
+        else if (chunks)          { chunks->push_back({key, val.toLongLong()}); }
+    }
+    return true;
+}
+
+} // namespace
+
+ChunkStore::ChunkStore(QString root) : m_root(std::move(root)) {}
+
+bool ChunkStore::isManifest(const QString& path) {
+    return path.endsWith(manifestSuffix(), Qt::CaseInsensitive);
+}
+
+QString ChunkStore::chunkPath(const QByteArray& hexId) const {
+    const QString id = QString::fromLatin1(hexId);
+    return QDir(m_root).absoluteFilePath(id.left(2) + "/" + id.mid(2, 2) + "/" + id);
+}
+
+bool ChunkStore::putChunk(const QByteArray& hexId, const QByteArray& data) const {
+    const QString path = chunkPath(hexId);
+    if (QFile::exists(path)) return true; // 去重：已有同内容块
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    if (f.write(data) != data.size()) { f.cancelWriting(); return false; }
+    if (f.commit()) return true;
+    return QFile::exists(path); // 其它通道抢先写入了同一块
+}
+
+bool ChunkStore::storeFile(const QString& srcPath, const QString& manifestPath,
+                           const std::function<bool()>& cancelled) const {
+    QReadLocker guard(&gcLock());
+
+    QFile in(srcPath);
+    if (!in.open(QIODevice::ReadOnly)) return false;
+
+    QCryptographicHash whole(QCryptographicHash::Sha256);
+    QByteArray buf; buf.resize(4 * kMaxChunk);
+    qint64 have = 0, pos = 0, total = 0;
+    bool eof = false;
+    QByteArray body;
+
+    for (;;) {
+        if (cancelled && cancelled()) return false;
+
+        // 剩余不足一个最大块且未到文件尾：前移剩余数据后继续读
+        if (!eof && have - pos < kMaxChunk) {
+            if (pos > 0) {
+                std::memmove(buf.data(), buf.constData() + pos, size_t(have - pos));
+                have -= pos; pos = 0;
+            }
+            const qint64 n = in.read(buf.data() + have, buf.size() - have);
+            if (n < 0) return false;
+            if (n == 0) eof = true; else have += n;
+            continue;
+        }
+        if (pos >= have) break;
+
+        const int len = cutPoint(reinterpret_cast<const uchar*>(buf.constData() + pos), int(have - pos));
+        const QByteArray chunk = QByteArray::fromRawData(buf.constData() + pos, len);
+        const QByteArray id = QCryptographicHash::hash(chunk, QCryptographicHash::Sha256).toHex();
+        if (!putChunk(id, chunk)) return false;
+        whole.addData(chunk);
+        body += id + ' ' + QByteArray::number(len) + '\n';
+        total += len;
+        pos   += len;
+    }
+
+    QSaveFile mf(manifestPath);
+    if (!mf.open(QIODevice::WriteOnly)) return false;
+    mf.write("PBCM 1\n");
+    mf.write("size " + QByteArray::number(total) + "\n");
+    mf.write("sha256 " + whole.result().toHex() + "\n");
+    mf.write(body);
+    return mf.commit();
+}
+
+bool ChunkStore::restoreFile(const QString& manifestPath, const QString& chunksRoot, const QString& outPath) {
+    qint64 totalSize = 0;
+    QByteArray wholeHex;
+    QList<ManifestChunk> chunks;
+    if (!readManifest(manifestPath, &totalSize, &wholeHex, &chunks)) return false;
+
+    const ChunkStore store(chunksRoot);
+    QDir().mkpath(QFileInfo(outPath).absolutePath());
+    const QString part = outPath + ".part";
+    QFile out(part);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+
+    QCryptographicHash whole(QCryptographicHash::Sha256);
+    qint64 written = 0;
+    for (const ManifestChunk& c : chunks) {
+        QFile cf(store.chunkPath(c.id));
+        if (!cf.open(QIODevice::ReadOnly)) { out.close(); QFile::remove(part); return false; }
+        const QByteArray data = cf.readAll();
+        if (data.size() != c.len || out.write(data) != data.size()) {
+            out.close(); QFile::remove(part); return false;
+        }
+        whole.addData(data);
+        written += data.size();
+    }
+    out.close();
+
+    if (written != totalSize || whole.result().toHex() != wholeHex) { QFile::remove(part); return false; }
+    if (QFile::exists(outPath)) QFile::remove(outPath);
+    if (!QFile::rename(part, outPath)) { QFile::remove(part); return false; }
+    return true;
+}
+
+int ChunkStore::collectGarbage(const QStringList& manifestRoots) const {
+    QWriteLocker guard(&gcLock());
+    if (!QDir(m_root).exists()) return 0;
+
+    // 标记：所有清单引用到的块
+    QSet<QByteArray> live;
+    for (const QString& root : manifestRoots) {
+        if (!QDir(root).exists()) continue;
+        QDirIterator it(root, QStringList() << ("*" + manifestSuffix()), QDir::Files, QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            QList<ManifestChunk> chunks;
+            if (!readManifest(it.next(), nullptr, nullptr, &chunks)) return 0; // 读不全就不删，宁可多留
+            for (const ManifestChunk& c : chunks) live.insert(c.id);
+        }
+    }
+
+    // 清除：未被引用的块
+    int removed = 0;
+    QDirIterator it(m_root, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        if (!live.contains(it.fileName().toLatin1()) && QFile::remove(it.filePath())) ++removed;
+    }
+    return removed;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <functional>
+
+/**
+ * @brief 目标盘上的去重分块仓库（.plugbackup_meta/chunks）
+ * - 内容定义分块（FastCDC，gear 滚动哈希，16K/64K/256K），块以 SHA-256 命名：chunks/ab/cd/<hex>
+ * - 历史版本/删除留存以清单文件（*.pbm）记录块序列，相同内容的块只存一份
+ * - 清单格式（文本）：
+ *     PBCM 1
+ *     size <总字节>
+ *     sha256 <整文件摘要>
+ *     <块摘要> <块长度>   （每块一行）
+ * - 保留期清理后做一次标记-清除，删掉不再被任何清单引用的块
+ */
+class ChunkStore {
+public:
+    explicit ChunkStore(QString root = QString());
+
+    static QString manifestSuffix() { return QStringLiteral(".pbm"); }
+    static bool    isManifest(const QString& path);
+
+    // 把文件切块入库（已存在的块不重复写）并写出清单；cancelled() 为真时中止
+    bool storeFile(const QString& srcPath, const QString& manifestPath,
+                   const std::function<bool()>& cancelled = {}) const;
+
+    // 按清单重组文件（先写 .part，整文件摘要一致后再改名）
+    static bool restoreFile(const QString& manifestPath, const QString& chunksRoot, const QString& outPath);
+
+    // 标记-清除：扫描 manifestRoots 下所有清单，删除未被引用的块；返回删除的块数
+    int collectGarbage(const QStringList& manifestRoots) const;
+
+private:
+    QString chunkPath(const QByteArray& hexId) const;
+    bool    putChunk(const QByteArray& hexId, const QByteArray& data) const;
+
+    QString m_root;
+};
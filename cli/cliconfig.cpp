@@ -0,0 +1,117 @@
+#include "cliconfig.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+static QStringList toStringList(const QJsonValue& v) {
+    QStringList out;
+    for (const QJsonValue& e : v.toArray()) {
+        const QString s = e.toString().trimmed();
+        if (!s.isEmpty()) out << s;
+    }
+    return out;
+}
+
+static bool isSubPath(const QString& parent, const QString& child) {
+    if (parent.isEmpty() || child.isEmpty()) return false;
+    const QString p = QDir(parent).absolutePath() + QDir::separator();
+    const QString c = QDir(child).absolutePath();
+    return c.startsWith(p, Qt::CaseInsensitive);
+}
+
+bool CliConfig::load(const QString& path, CliConfig* out, QString* err) {
+    auto fail = [&](const QString& e){ if (err) *err = e; return false; };
+
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly))
+        return fail(QCoreApplication::translate("CliConfig", "无法打开配置文件：%1").arg(path));
+    QJsonParseError pe;
+    const QJsonDocument doc = QJsonDocument::fromJson(f.readAll(), &pe);
+    if (pe.error != QJsonParseError::NoError || !doc.isObject())
+        return fail(QCoreApplication::translate("CliConfig", "配置文件不是合法的 JSON 对象：%1").arg(pe.errorString()));
+
+    const QDir base = QFileInfo(path).absoluteDir();
+    auto absPath = [&](const QString& p){ return QDir::cleanPath(base.absoluteFilePath(p)); };
+
+    const QJsonObject o = doc.object();
+    CliConfig c;
+    c.destination = o.value("destination").toString();
+    if (!c.destination.isEmpty()) c.destination = absPath(c.destination);
+
+    for (const QJsonValue& v : o.value("sources").toArray()) {
+        Source s;
+        if (v.isString()) {
+            s.path = v.toString();
+        } else {
+            const QJsonObject so = v.toObject();
+            s.path   = so.value("path").toString();
+            s.nsName = so.value("nsName").toString();
+            s.ignore = toStringList(so.value("ignore"));
+        }
+        if (s.path.isEmpty()) continue;
+        s.path = absPath(s.path);
+        c.sources.push_back(s);
+    }
+
+    BackupWorker::Options& d = c.common;
+    d.ignoreGlobs          = toStringList(o.value("ignore"));
+    d.verifyAfterWrite     = o.value("verifyAfterWrite").toBool(d.verifyAfterWrite);
+    d.maxRetries           = o.value("maxRetries").toInt(d.maxRetries);
+    d.speedLimitBps        = qint64(o.value("speedLimitMBps").toDouble(0) * 1024 * 1024);
+    d.keepVersionsOnChange = o.value("keepVersionsOnChange").toBool(d.keepVersionsOnChange);
+    d.keepDeletedInVault   = o.value("keepDeletedInVault").toBool(d.keepDeletedInVault);
+    d.allowMassDeletion    = o.value("allowMassDeletion").toBool(d.allowMassDeletion);
+    d.retentionDays        = o.value("retentionDays").toInt(d.retentionDays);
+    d.keepVersions         = o.value("keepVersions").toInt(d.keepVersions);
+    d.keepHourly           = o.value("keepHourly").toInt(d.keepHourly);
+    d.keepDaily            = o.value("keepDaily").toInt(d.keepDaily);
+    d.keepWeekly           = o.value("keepWeekly").toInt(d.keepWeekly);
+    d.chunkStoreVault      = o.value("chunkStoreVault").toBool(d.chunkStoreVault);
+    d.deltaTransfer        = o.value("deltaTransfer").toBool(d.deltaTransfer);
+    d.copyLanes            = o.value("copyLanes").toInt(d.copyLanes);
+    if (o.contains("hashAlgorithm") && !Digest::fromName(o.value("hashAlgorithm").toString(), &d.hashAlgo))
+        return fail(QCoreApplication::translate("CliConfig", "未知的摘要算法（hashAlgorithm）：%1")
+                        .arg(o.value("hashAlgorithm").toString()));
+
+    const QJsonObject dm = o.value("daemon").toObject();
+    c.intervalMinutes    = dm.value("intervalMinutes").toInt(c.intervalMinutes);
+    c.watch              = dm.value("watch").toBool(c.watch);
+    c.stableSeconds      = dm.value("stableSeconds").toInt(c.stableSeconds);
+    c.deviceCheckMinutes = dm.value("deviceCheckMinutes").toInt(c.deviceCheckMinutes);
+
+    *out = c;
+    return true;
+}
+
+// 与界面 onValidate 相同的规则：目标不能是源或位于源内，源之间不能互相包含
+QString CliConfig::validate() const {
+    if (sources.isEmpty())    return QCoreApplication::translate("CliConfig", "配置中没有源目录（sources）。");
+    if (destination.isEmpty()) return QCoreApplication::translate("CliConfig", "配置中没有目标目录（destination）。");
+    for (const Source& s : sources) {
+        if (!QFileInfo(s.path).isDir())
+            return QCoreApplication::translate("CliConfig", "源目录不存在：%1").arg(s.path);
+        if (s.path.compare(destination, Qt::CaseInsensitive) == 0)
+            return QCoreApplication::translate("CliConfig", "目标目录与源目录相同：%1").arg(destination);
+        if (isSubPath(s.path, destination))
+            return QCoreApplication::translate("CliConfig", "目标目录在源目录内：\n源：%1\n目标：%2").arg(s.path, destination);
+        for (const Source& t : sources) {
+            if (&s != &t && isSubPath(s.path, t.path))
+                return QCoreApplication::translate("CliConfig", "源目录互为包含：\n%1\n包含了\n%2").arg(s.path, t.path);
+        }
+    }
+    return QString();
+}
+
+BackupWorker::Options CliConfig::optionsFor(const Source& s) const {
+    BackupWorker::Options o = common;
+    o.srcDir = s.path;
+    o.dstDir = destination;
+    o.nsName = s.nsName;
+    o.ignoreGlobs += s.ignore;
+    return o;
+}
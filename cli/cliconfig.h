@@ -0,0 +1,45 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <QList>
+
+#include "backupworker.h"
+
+/**
+ * @brief plugbackup-cli 的 JSON 配置
+ * {
+ *   "destination": "/mnt/usb/backup",
+ *   "sources": ["/srv/docs", {"path": "/srv/mail", "nsName": "mail", "ignore": ["*.lock"]}],
+ *   "ignore": ["*.tmp", "*.log"],
+ *   "verifyAfterWrite": true, "maxRetries": 3, "speedLimitMBps": 0,
+ *   "keepVersionsOnChange": true, "keepDeletedInVault": true, "retentionDays": 7,
+ *   "keepVersions": 0, "keepHourly": 0, "keepDaily": 0, "keepWeekly": 0, // 留存策略，0 = 不启用该条；任一规则选中即保留，keepVersions 为总上限
+ *   "chunkStoreVault": false, "deltaTransfer": false, "copyLanes": 2,
+ *   "allowMassDeletion": false,                   // 源中不见的文件过半时照常移走（默认暂缓，本轮记为未完成）
+ *   "hashAlgorithm": "sha256",                      // sha256 | blake3 | xxh128（未编译进来时退回 sha256）
+ *   "daemon": { "intervalMinutes": 30, "watch": true, "stableSeconds": 120, "deviceCheckMinutes": 1 }
+ * }
+ * 未给出的键取 BackupWorker::Options 的默认值；相对路径相对于配置文件所在目录。
+ */
+struct CliConfig {
+    struct Source {
+        QString     path;
+        QString     nsName;        // 空 = 自动生成
+        QStringList ignore;        // 追加在全局 ignore 之后
+    };
+
+    QString               destination;
+    QList<Source>         sources;
+    BackupWorker::Options common;  // 除 srcDir/dstDir/nsName 外的公共选项
+
+    // 守护模式
+    int  intervalMinutes    = 0;   // 0 = 不定时
+    bool watch              = false;
+    int  stableSeconds      = 120;
+    int  deviceCheckMinutes = 1;
+
+    static bool load(const QString& path, CliConfig* out, QString* err);
+
+    QString validate() const;                          // 空 = 通过
+    BackupWorker::Options optionsFor(const Source& s) const;
+};
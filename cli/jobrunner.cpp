@@ -0,0 +1,179 @@
+#include "jobrunner.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+
+#include <utility>
+
+static QString humanEta(qint64 sec) {
+    if (sec < 0) return QStringLiteral("--:--:--");
+    const int h = int(sec/3600), m = int((sec%3600)/60), s = int(sec%60);
+    return QString::asprintf("%02d:%02d:%02d", h, m, s);
+}
+static QString humanSpeed(double bps) {
+    if (bps <= 0) return QStringLiteral("0 MB/s");
+    return QString::asprintf("%.2f MB/s", bps / (1024.0*1024.0));
+}
+
+JobRunner::JobRunner(CliConfig cfg, Output out, QObject* parent)
+    : QObject(parent), m_cfg(std::move(cfg)), m_out(out) {
+    m_tick = new QTimer(this);
+    m_tick->setInterval(1000);
+    connect(m_tick, &QTimer::timeout, this, &JobRunner::printProgress);
+}
+
+bool JobRunner::destinationOnline() const {
+    const QFileInfo info(m_cfg.destination);
+    return info.exists() && info.isDir() && info.isWritable();
+}
+
+void JobRunner::log(const QString& msg) const {
+    if (m_out == Output::Json) {
+        emitJson({{"event", "log"}, {"message", msg}});
+    } else if (m_out == Output::Text) {
+        QTextStream(stderr) << QDateTime::currentDateTime().toString("yyyy-MM-dd HH:mm:ss")
+                            << "  " << msg << "\n";
+    }
+}
+
+void JobRunner::emitJson(const QJsonObject& obj) const {
+    QJsonObject o = obj;
+    o.insert("time", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    QTextStream out(stdout);
+    out << QJsonDocument(o).toJson(QJsonDocument::Compact) << "\n";
+    out.flush();
+}
+
+bool JobRunner::startRound(const QString& reason, const DirtyJournal* journal) {
+    if (isRunning()) return false;
+    if (!destinationOnline()) {
+        log(tr("目标目录不可写或不存在（可能未插入移动硬盘）：%1").arg(m_cfg.destination));
+        return false;
+    }
+
+    m_jobs.clear();
+    m_failedFiles = 0;
+    m_allOk = true;
+
+    const bool incremental = journal && !journal->needsFullScan();
+    QList<QPair<CliConfig::Source, BackupWorker::Options>> plan;
+    for (const CliConfig::Source& s : m_cfg.sources) {
+        BackupWorker::Options opt = m_cfg.optionsFor(s);
+        if (incremental && !journal->scopeFor(s.path, &opt.scopeDirs, &opt.scopeTrees)) continue;
+        plan.append({s, opt});
+    }
+    if (plan.isEmpty()) {
+        // 监听到的改动都不在源内（或已被忽略）：本轮无事可做，照常收尾
+        log(tr("无改动（%1）").arg(reason));
+        QTimer::singleShot(0, this, [this]{ emit roundFinished(true, 0); });
+        return true;
+    }
+    log(tr("开始%1备份（%2）：%3 个源 → %4").arg(incremental ? tr("增量") : QString())
+            .arg(reason).arg(plan.size()).arg(m_cfg.destination));
+
+    for (const auto& p : std::as_const(plan)) {
+        const CliConfig::Source& s = p.first;
+        const int idx = m_jobs.size();
+        auto* worker = new BackupWorker(p.second);
+        auto* th = new QThread(this);
+        th->setObjectName(QStringLiteral("BackupWorker:%1").arg(s.path));
+        worker->moveToThread(th);
+
+        Job job;
+        job.src = s.path;
+        job.worker = worker;
+        job.thread = th;
+        job.progress = worker->progress();
+        m_jobs.push_back(job);
+
+        connect(th, &QThread::started, worker, &BackupWorker::run);
+
+        connect(worker, &BackupWorker::stateChanged, this, [this, idx](const QString& st){
+            m_jobs[idx].state = st; m_jobs[idx].dirty = true;
+        });
+        connect(worker, &BackupWorker::fileFailed, this, [this, idx](const QString& rel, const QString& err){
+            ++m_failedFiles;
+            if (m_out == Output::Json)
+                emitJson({{"event", "file_failed"}, {"src", m_jobs[idx].src}, {"rel", rel}, {"error", err}});
+            else if (m_out == Output::Text)
+                QTextStream(stderr) << "FAIL  " << m_jobs[idx].src << " :: " << rel << " :: " << err << "\n";
+        });
+        connect(worker, &BackupWorker::deviceOffline, this, [this](const QString& phase){
+            log(tr("设备离线/变更，等待中… %1").arg(phase));
+        });
+        connect(worker, &BackupWorker::deviceOnline, this, [this]{ log(tr("设备已恢复")); });
+
+        // 收口顺序与界面一致：worker finished -> 线程 quit；deleteLater 均在 finished 之后
+        connect(worker, &BackupWorker::finished, th,     &QThread::quit);
+        connect(worker, &BackupWorker::finished, worker, &QObject::deleteLater);
+        connect(th,     &QThread::finished,      th,     &QObject::deleteLater);
+
+        connect(worker, &BackupWorker::finished, this, [this, idx](bool ok, const QString& summary){
+            Job& j = m_jobs[idx];
+            j.state = summary; j.dirty = true;
+            if (!ok) m_allOk = false;
+            const BackupProgress::Snapshot s = j.progress->snapshot();
+            if (m_out == Output::Json)
+                emitJson({{"event", "finished"}, {"src", j.src}, {"ok", ok}, {"summary", summary},
+                          {"bytesDone", s.bytesDone}, {"bytesTotal", s.bytesTotal},
+                          {"filesDone", s.filesDone}, {"filesCopied", s.filesCopied}, {"filesFailed", s.filesFailed}});
+            else
+                log(QString("%1 · %2").arg(j.src, summary));
+        });
+        connect(th, &QThread::finished, this, [this]{
+            if (--m_running > 0) return;
+            m_tick->stop();
+            printProgress();
+            if (m_out == Output::Json)
+                emitJson({{"event", "round"}, {"ok", m_allOk}, {"failedFiles", m_failedFiles}});
+            else
+                log(m_allOk ? tr("本轮完成") : tr("本轮部分失败：%1 个文件").arg(m_failedFiles));
+            emit roundFinished(m_allOk, m_failedFiles);
+        });
+
+        ++m_running;
+    }
+
+    for (const Job& j : std::as_const(m_jobs)) j.thread->start();
+    m_tick->start();
+    return true;
+}
+
+void JobRunner::stopAll() {
+    for (Job& j : m_jobs) {
+        if (j.worker) {
+            j.worker->requestPause(false);
+            j.worker->requestStop();
+        }
+        if (j.thread && !j.thread->isFinished()) j.thread->requestInterruption();
+    }
+}
+
+// 每秒读一次各任务的进度快照；字节/文件数与状态都没变的任务不输出
+void JobRunner::printProgress() {
+    if (m_out == Output::Quiet) return;
+    for (Job& j : m_jobs) {
+        const BackupProgress::Snapshot s = j.progress->snapshot();
+        if (s.bytesDone != j.lastBytes || s.filesDone != j.lastFiles) j.dirty = true;
+        if (!j.dirty) continue;
+        j.dirty = false;
+        j.lastBytes = s.bytesDone;
+        j.lastFiles = s.filesDone;
+        if (m_out == Output::Json) {
+            emitJson({{"event", "progress"}, {"src", j.src}, {"bytesDone", s.bytesDone}, {"bytesTotal", s.bytesTotal},
+                      {"filesDone", s.filesDone}, {"filesTotal", s.filesTotal},
+                      {"bytesPerSec", s.bytesPerSec}, {"etaSec", s.etaSec}, {"state", j.state}});
+        } else {
+            const int pct = s.bytesTotal > 0 ? int((s.bytesDone * 100) / qMax<qint64>(s.bytesTotal, 1)) : 0;
+            QTextStream(stderr) << QString("[%1] %2%  (%3 / %4 MB, %5 / %6 files)  %7  ETA %8  %9\n")
+                                   .arg(j.src).arg(pct).arg(s.bytesDone/1024/1024).arg(s.bytesTotal/1024/1024)
+                                   .arg(s.filesDone).arg(s.filesTotal)
+                                   .arg(humanSpeed(s.bytesPerSec), humanEta(s.etaSec), j.state);
+        }
+    }
+}
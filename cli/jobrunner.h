@@ -0,0 +1,60 @@
+#pragma once
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+#include <QJsonObject>
+#include <memory>
+
+#include "BackupProgress.h"
+#include "cliconfig.h"
+#include "DirtyJournal.h"
+
+class QThread;
+class QTimer;
+
+/**
+ * @brief 无界面任务编排：一轮 = 每个源目录一个 BackupWorker（各自线程）
+ * - 进度：每秒读取 BackupWorker::progress() 的计数快照；状态来自 stateChanged，失败项来自 fileFailed
+ * - 输出三种：文本（每秒一行/任务，写 stderr）、JSON（每事件一行 NDJSON，写 stdout）、静默
+ * - 所有线程收尾后发 roundFinished
+ */
+class JobRunner : public QObject {
+    Q_OBJECT
+public:
+    enum class Output { Text, Json, Quiet };
+
+    JobRunner(CliConfig cfg, Output out, QObject* parent = nullptr);
+
+    bool isRunning() const { return m_running > 0; }
+    bool destinationOnline() const;                 // 目标存在且可写
+    // 正在运行/目标离线返回 false；给出 journal（且日志完整）时只扫描有改动的目录，无改动的源跳过
+    bool startRound(const QString& reason, const DirtyJournal* journal = nullptr);
+    void stopAll();                                 // 请求所有任务停止（异步，收尾后仍发 roundFinished）
+
+    void log(const QString& msg) const;             // 带时间戳的日志行
+
+signals:
+    void roundFinished(bool allOk, int failedFiles);
+
+private:
+    struct Job {
+        QString               src;
+        QPointer<BackupWorker> worker;
+        QThread*              thread = nullptr;
+        std::shared_ptr<BackupProgress> progress;   // worker 销毁后仍可读最终值
+        qint64                lastBytes = -1, lastFiles = -1; // 上次输出时的快照
+        QString               state;
+        bool                  dirty = false;        // 状态在上次输出后有变化
+    };
+
+    void printProgress();
+    void emitJson(const QJsonObject& obj) const;
+
+    CliConfig     m_cfg;
+    Output        m_out;
+    QVector<Job>  m_jobs;
+    int           m_running     = 0;
+    int           m_failedFiles = 0;
+    bool          m_allOk       = true;
+    QTimer*       m_tick        = nullptr;
+};
@@ -0,0 +1,106 @@
+#include "cliconfig.h"
+#include "jobrunner.h"
+#include "scheduler.h"
+
+#include <QAtomicInt>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+#include <QTimer>
+
+#include <csignal>
+
+/**
+ * plugbackup-cli：无界面运行备份（只依赖 QtCore）
+ *   plugbackup-cli -c backup.json            跑一轮后退出
+ *   plugbackup-cli -c backup.json --daemon   常驻：定时/监听/设备检测触发
+ * 退出码见 ExitCode；SIGINT/SIGTERM 会请求任务停止并等待收尾。
+ */
+enum ExitCode {
+    ExitOk          = 0,    // 全部成功
+    ExitPartial     = 1,    // 有文件失败
+    ExitConfig      = 2,    // 参数/配置错误
+    ExitDestOffline = 3,    // 目标不可写或不存在
+    ExitInterrupted = 130   // 被信号中断
+};
+
+static QAtomicInt g_stopSignal{0};
+static void onStopSignal(int) { g_stopSignal.storeRelease(1); } // 只置位，由事件循环轮询处理
+
+int main(int argc, char* argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("plugbackup-cli");
+    QCoreApplication::setOrganizationName("liangyejing");
+    QCoreApplication::setOrganizationDomain("lyj.org");
+
+    QCommandLineParser p;
+    p.setApplicationDescription(QCoreApplication::translate("main", "PlugBackup 无界面备份"));
+    p.addHelpOption();
+    const QCommandLineOption optConfig({"c", "config"}, QCoreApplication::translate("main", "JSON 配置文件"), "file");
+    const QCommandLineOption optDaemon({"d", "daemon"}, QCoreApplication::translate("main", "守护模式：定时/监听/设备检测触发"));
+    const QCommandLineOption optJson("json", QCoreApplication::translate("main", "以 NDJSON 输出事件（stdout）"));
+    const QCommandLineOption optQuiet({"q", "quiet"}, QCoreApplication::translate("main", "不输出进度"));
+    const QCommandLineOption optCheck("check", QCoreApplication::translate("main", "只校验配置后退出"));
+    p.addOptions({optConfig, optDaemon, optJson, optQuiet, optCheck});
+    p.process(app);
+
+    QTextStream err(stderr);
+    if (!p.isSet(optConfig)) { err << p.helpText(); return ExitConfig; }
+
+    CliConfig cfg;
+    QString e;
+    if (!CliConfig::load(p.value(optConfig), &cfg, &e)) { err << e << "\n"; return ExitConfig; }
+    e = cfg.validate();
+    if (!e.isEmpty()) { err << e << "\n"; return ExitConfig; }
+    if (p.isSet(optCheck)) { err << QCoreApplication::translate("main", "配置有效") << "\n"; return ExitOk; }
+
+    const JobRunner::Output out = p.isSet(optJson)  ? JobRunner::Output::Json
+                                : p.isSet(optQuiet) ? JobRunner::Output::Quiet
+                                                    : JobRunner::Output::Text;
+    JobRunner runner(cfg, out);
+    if (!Digest::available(cfg.common.hashAlgo))
+        runner.log(QCoreApplication::translate("main", "本版本未编译 %1，改用 %2")
+                       .arg(Digest::name(cfg.common.hashAlgo), Digest::backend(cfg.common.hashAlgo)));
+
+    std::signal(SIGINT,  onStopSignal);
+    std::signal(SIGTERM, onStopSignal);
+    bool interrupted = false;
+
+    if (p.isSet(optDaemon)) {
+        Scheduler sched(cfg, &runner);
+        QObject::connect(&sched, &Scheduler::stopped, &app, [&]{ app.exit(interrupted ? ExitInterrupted : ExitOk); });
+
+        QTimer sigPoll;
+        QObject::connect(&sigPoll, &QTimer::timeout, &app, [&]{
+            if (!g_stopSignal.loadAcquire() || interrupted) return;
+            interrupted = true;
+            runner.log(QCoreApplication::translate("main", "收到停止信号，等待任务收尾…"));
+            sched.shutdown();
+        });
+        sigPoll.start(200);
+
+        sched.start();
+        return app.exec();
+    }
+
+    // 单轮
+    if (!runner.destinationOnline()) {
+        err << QCoreApplication::translate("main", "目标目录不可写或不存在（可能未插入移动硬盘）：%1").arg(cfg.destination) << "\n";
+        return ExitDestOffline;
+    }
+    QObject::connect(&runner, &JobRunner::roundFinished, &app, [&](bool ok, int){
+        app.exit(interrupted ? ExitInterrupted : ok ? ExitOk : ExitPartial);
+    });
+
+    QTimer sigPoll;
+    QObject::connect(&sigPoll, &QTimer::timeout, &app, [&]{
+        if (!g_stopSignal.loadAcquire() || interrupted) return;
+        interrupted = true;
+        runner.log(QCoreApplication::translate("main", "收到停止信号，等待任务收尾…"));
+        runner.stopAll();
+    });
+    sigPoll.start(200);
+
+    if (!runner.startRound(QCoreApplication::translate("main", "命令行"))) return ExitDestOffline;
+    return app.exec();
+}
@@ -0,0 +1,113 @@
+#include "scheduler.h"
+#include "jobrunner.h"
+#include "recursivewatcher.h"
+
+#include <QDateTime>
+#include <QTimer>
+
+Scheduler::Scheduler(const CliConfig& cfg, JobRunner* runner, QObject* parent)
+    : QObject(parent), m_cfg(cfg), m_runner(runner) {
+    m_timerInterval = new QTimer(this);
+    connect(m_timerInterval, &QTimer::timeout, this, &Scheduler::onIntervalTick);
+
+    m_timerDevice = new QTimer(this);
+    connect(m_timerDevice, &QTimer::timeout, this, &Scheduler::onDeviceTick);
+
+    m_timerStab = new QTimer(this);
+    m_timerStab->setSingleShot(true);
+    connect(m_timerStab, &QTimer::timeout, this, &Scheduler::onStabilityTick);
+
+    connect(m_runner, &JobRunner::roundFinished, this, &Scheduler::onRoundFinished);
+}
+
+void Scheduler::start() {
+    m_deviceOnline = m_runner->destinationOnline();
+    m_timerDevice->start(qMax(1, m_cfg.deviceCheckMinutes) * 60 * 1000);
+    if (m_cfg.intervalMinutes > 0) m_timerInterval->start(m_cfg.intervalMinutes * 60 * 1000);
+
+    if (m_cfg.watch) {
+        m_watcher = new RecursiveWatcher(this);
+        connect(m_watcher, &RecursiveWatcher::changed,    this, &Scheduler::onWatchedChanged);
+        connect(m_watcher, &RecursiveWatcher::overflowed, this, &Scheduler::onWatchOverflow);
+        QStringList roots;
+        for (const CliConfig::Source& s : m_cfg.sources) roots << s.path;
+        m_watcher->setRoots(roots);
+        for (const QString& r : m_watcher->roots()) {
+            const RecursiveWatcher::Backend b = m_watcher->backendFor(r);
+            m_runner->log(tr("监听 %1（%2）").arg(r, b == RecursiveWatcher::Backend::Fanotify ? QStringLiteral("fanotify")
+                                                 : b == RecursiveWatcher::Backend::Inotify ? QStringLiteral("inotify")
+                                                                                            : QStringLiteral("QFileSystemWatcher")));
+        }
+    }
+
+    m_pendingChanges = true; // 启动即补一轮
+    tryRun(tr("守护进程启动"));
+}
+
+void Scheduler::shutdown() {
+    m_shuttingDown = true;
+    m_timerInterval->stop();
+    m_timerDevice->stop();
+    m_timerStab->stop();
+    if (m_runner->isRunning()) m_runner->stopAll(); // roundFinished → stopped
+    else emit stopped();
+}
+
+void Scheduler::tryRun(const QString& reason, bool incremental) {
+    if (m_shuttingDown) return;
+    incremental = incremental && m_cfg.watch; // 没开监听时日志是空的，按日志只会“无改动”
+    // 推迟的全量触发（启动/定时）补跑时不能降为按日志的增量：先把日志标为丢失
+    if (m_runner->isRunning()) { m_pendingChanges = true; if (!incremental) m_journal.markLost(); return; }
+    if (!m_runner->destinationOnline()) {                   // 设备回到在线时再补
+        m_pendingChanges = true;
+        if (!incremental) m_journal.markLost();
+        return;
+    }
+    m_pendingChanges = false;
+    if (m_runner->startRound(reason, incremental ? &m_journal : nullptr))
+        m_journal.reset(); // 本轮已覆盖此前的改动；之后的事件记入新日志
+}
+
+void Scheduler::onRoundFinished(bool allOk, int) {
+    if (m_shuttingDown) { emit stopped(); return; }
+    if (!allOk && m_cfg.watch) m_journal.markLost(); // 未覆盖的改动已无从得知 → 下次全量
+    // 本轮期间有新改动：按稳定窗口补跑
+    if (m_pendingChanges) m_timerStab->start(qMax(1, m_cfg.stableSeconds) * 1000);
+}
+
+void Scheduler::onIntervalTick() { tryRun(tr("定时触发")); }
+
+void Scheduler::onDeviceTick() {
+    const bool online = m_runner->destinationOnline();
+    if (online == m_deviceOnline) return;
+    m_deviceOnline = online;
+    if (online) {
+        m_runner->log(tr("设备已在线"));
+        if (m_pendingChanges) tryRun(tr("设备恢复在线"), true);
+    } else {
+        m_runner->log(tr("设备离线：暂停自动备份"));
+    }
+}
+
+void Scheduler::onStabilityTick() {
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const qint64 windowMs = qint64(qMax(1, m_cfg.stableSeconds)) * 1000;
+    if (now - m_lastChangeMs < windowMs) { m_timerStab->start(int(windowMs - (now - m_lastChangeMs))); return; }
+    tryRun(tr("稳定窗口结束"), true);
+}
+
+void Scheduler::onWatchedChanged(const QStringList& dirs, const QStringList& trees) {
+    for (const QString& d : dirs)  m_journal.markDir(d);
+    for (const QString& t : trees) m_journal.markTree(t);
+    m_pendingChanges = true;
+    m_lastChangeMs = QDateTime::currentMSecsSinceEpoch();
+    m_timerStab->start(qMax(1, m_cfg.stableSeconds) * 1000);
+}
+
+void Scheduler::onWatchOverflow() {
+    m_runner->log(tr("监听事件溢出或超出 watch 上限：下一轮全量扫描"));
+    m_journal.markLost();
+    m_pendingChanges = true;
+    m_lastChangeMs = QDateTime::currentMSecsSinceEpoch();
+    m_timerStab->start(qMax(1, m_cfg.stableSeconds) * 1000);
+}
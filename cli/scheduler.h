@@ -0,0 +1,52 @@
+#pragma once
+#include <QObject>
+#include <QSet>
+
+#include "cliconfig.h"
+#include "DirtyJournal.h"
+
+class JobRunner;
+class RecursiveWatcher;
+class QTimer;
+
+/**
+ * @brief 守护模式的调度（与界面“自动化”一致）
+ * - 定时触发（intervalMinutes > 0）
+ * - 监听源目录变化，稳定窗口（stableSeconds）内无新改动才触发
+ * - 设备检测：目标回到在线且有待备份的改动 → 立即触发
+ * 正在备份时到来的触发只记为“待备份”，本轮结束后补跑。
+ */
+class Scheduler : public QObject {
+    Q_OBJECT
+public:
+    Scheduler(const CliConfig& cfg, JobRunner* runner, QObject* parent = nullptr);
+
+    void start();       // 启动计时器/监听，并先跑一轮
+    void shutdown();    // 停止调度与任务；任务收尾后发 stopped
+
+signals:
+    void stopped();
+
+private slots:
+    void onIntervalTick();
+    void onDeviceTick();
+    void onStabilityTick();
+    void onWatchedChanged(const QStringList& dirs, const QStringList& trees);
+    void onWatchOverflow();
+    void onRoundFinished(bool allOk, int failedFiles);
+
+private:
+    void tryRun(const QString& reason, bool incremental = false); // incremental：按监听日志只扫改动的目录
+
+    CliConfig           m_cfg;
+    JobRunner*          m_runner;
+    RecursiveWatcher*   m_watcher       = nullptr;
+    DirtyJournal        m_journal;          // 监听到的脏目录（未开监听时保持“丢失”，每轮全量）
+    QTimer*             m_timerInterval = nullptr;
+    QTimer*             m_timerDevice   = nullptr;
+    QTimer*             m_timerStab     = nullptr;
+    bool                m_pendingChanges = false;
+    bool                m_deviceOnline   = false;
+    bool                m_shuttingDown   = false;
+    qint64              m_lastChangeMs   = 0;
+};
@@ -0,0 +1,131 @@
+#include "devicemonitor.h"
+
+#include <QStorageInfo>
+#include <QThread>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+#include <QFile>
+#endif
+
+DeviceMonitor::DeviceMonitor(QString dir) : m_dir(std::move(dir)) {}
+
+DeviceMonitor::~DeviceMonitor() {
+    stop();
+    closeHeld();
+}
+
+void DeviceMonitor::start() {
+    if (m_thread) return;
+    {
+        QStorageInfo st(m_dir);
+        QMutexLocker lk(&m_mutex);
+        m_expectedDevice = (st.isValid() && st.isReady()) ? st.device() : QByteArray();
+    }
+    m_quit.storeRelease(0);
+    m_hold = true;
+    recheck();
+    m_thread = QThread::create([this]{ loop(); });
+    m_thread->setObjectName(QStringLiteral("DeviceMonitor"));
+    m_thread->start();
+}
+
+void DeviceMonitor::stop() {
+    if (!m_thread) return;
+    m_quit.storeRelease(1);
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    QMutexLocker lk(&m_mutex);
+    m_hold = false;
+    closeHeld();                                            // 任务结束后不再占着目标，便于弹出
+}
+
+bool DeviceMonitor::isReady() {
+    if (!m_thread) return recheck();
+    return m_ready.loadAcquire() != 0;
+}
+
+bool DeviceMonitor::recheck() {
+    QMutexLocker lk(&m_mutex);
+    const bool ok = fullCheck();
+    m_ready.storeRelease(ok ? 1 : 0);
+    return ok;
+}
+
+// 调用方持锁
+bool DeviceMonitor::fullCheck() {
+    QStorageInfo st(m_dir);
+    bool ok = st.isValid() && st.isReady() && !st.isReadOnly()
+           && (m_expectedDevice.isEmpty() || st.device() == m_expectedDevice); // 同一盘符/挂载点被其他设备接管 → 否
+    if (!ok) { closeHeld(); return false; }
+#ifdef Q_OS_LINUX
+    struct stat sb;
+    if (::stat(QFile::encodeName(m_dir).constData(), &sb) != 0) { closeHeld(); return false; }
+    if (m_hold && (m_heldFd < 0 || quint64(sb.st_dev) != m_dev || quint64(sb.st_ino) != m_ino)) {
+        closeHeld();
+        m_heldFd = ::open(QFile::encodeName(m_dir).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        m_dev = quint64(sb.st_dev);
+        m_ino = quint64(sb.st_ino);
+    }
+#endif
+    return true;
+}
+
+// 调用方持锁
+bool DeviceMonitor::quickCheck() {
+#ifdef Q_OS_LINUX
+    if (m_heldFd < 0) return fullCheck();                   // 离线中：只能靠完整检查发现恢复
+    const QByteArray path = QFile::encodeName(m_dir);
+    struct stat sb;
+    if (::stat(path.constData(), &sb) != 0
+        || quint64(sb.st_dev) != m_dev || quint64(sb.st_ino) != m_ino) {
+        closeHeld();
+        return false;                                       // 已卸载/挂载点被替换
+    }
+    struct statvfs vb;
+    if (::fstatvfs(m_heldFd, &vb) != 0 || (vb.f_flag & ST_RDONLY)) return false; // 出错后被内核改为只读等
+    return true;
+#else
+    return fullCheck();
+#endif
+}
+
+void DeviceMonitor::closeHeld() {
+#ifdef Q_OS_LINUX
+    if (m_heldFd >= 0) ::close(m_heldFd);
+    m_heldFd = -1;
+    m_dev = m_ino = 0;
+#endif
+}
+
+void DeviceMonitor::loop() {
+#ifdef Q_OS_LINUX
+    // 挂载表变化时 poll 报 POLLPRI|POLLERR（无需重读文件）
+    const int mfd = ::open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+    while (!m_quit.loadAcquire()) {
+        bool mountsChanged = false;
+        if (mfd >= 0) {
+            pollfd p{mfd, POLLPRI, 0};
+            mountsChanged = ::poll(&p, 1, kQuickMs) > 0 && (p.revents & (POLLPRI | POLLERR));
+        } else {
+            QThread::msleep(kQuickMs);
+        }
+        if (m_quit.loadAcquire()) break;
+        QMutexLocker lk(&m_mutex);
+        const bool ok = mountsChanged ? fullCheck() : quickCheck();
+        m_ready.storeRelease(ok ? 1 : 0);
+    }
+    if (mfd >= 0) ::close(mfd);
+#else
+    while (!m_quit.loadAcquire()) {
+        QThread::msleep(kQuickMs);
+        if (m_quit.loadAcquire()) break;
+        recheck();
+    }
+#endif
+}
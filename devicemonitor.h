@@ -0,0 +1,51 @@
+#pragma once
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+
+class QThread;
+
+/**
+ * @brief 目标设备就绪监视：热路径只读一个原子标志，不再每次构造 QStorageInfo（解析挂载表 + statfs）
+ * - 完整检查（QStorageInfo）：可用、就绪、非只读，且设备名与首次记录的一致；通过后记下目录的 (st_dev, inode)
+ * - Linux：后台线程 poll /proc/self/mountinfo，挂载表变化时做完整检查；平时每 kQuickMs 做一次轻量检查：
+ *   stat 目标目录仍是记录的 (st_dev, inode)、statvfs 未变只读，两次系统调用，不解析挂载表
+ *   就绪期间持有目标目录 fd：旧文件系统不会被释放，其设备号也就不会被新插入的设备复用；离线即关闭，不妨碍卸载后重插
+ * - 其他平台：后台线程每 kQuickMs 做一次完整检查
+ * 未 start()（或已 stop()）时 isReady() 直接做完整检查、不持有 fd（bench 等不经 run() 的调用）。
+ * I/O 出错后用 recheck() 立即复核：后台线程最多滞后 kQuickMs。
+ */
+class DeviceMonitor {
+public:
+    static constexpr int kQuickMs = 500;
+
+    explicit DeviceMonitor(QString dir);
+    ~DeviceMonitor();
+    DeviceMonitor(const DeviceMonitor&) = delete;
+    DeviceMonitor& operator=(const DeviceMonitor&) = delete;
+
+    // 记录当前设备（此刻就绪时；否则不限定设备）并启动后台线程
+    void start();
+    void stop();
+
+    bool isReady();
+    bool recheck();                                         // 同步完整检查并更新标志
+
+private:
+    bool fullCheck();
+    bool quickCheck();
+    void closeHeld();
+    void loop();
+
+    QString     m_dir;
+    QByteArray  m_expectedDevice;
+    QAtomicInt  m_ready{0};
+    QAtomicInt  m_quit{0};
+    QThread*    m_thread = nullptr;
+    mutable QMutex m_mutex;                                 // 保护下面的检查状态（后台线程与 recheck 并发）
+    bool        m_hold = false;                             // start() 后才持有目录 fd
+    int         m_heldFd = -1;
+    quint64     m_dev = 0;
+    quint64     m_ino = 0;
+};
@@ -0,0 +1,197 @@
+#include "digest.h"
+
+#include <QCryptographicHash>
+
+#ifdef PLUGBACKUP_HAVE_OPENSSL
+#include <openssl/evp.h>
+#endif
+#ifdef PLUGBACKUP_HAVE_BLAKE3
+#include <blake3.h>
+#endif
+#ifdef PLUGBACKUP_HAVE_XXHASH
+#include <xxhash.h>
+#endif
+
+struct Digest::State {
+#ifdef PLUGBACKUP_HAVE_OPENSSL
+    EVP_MD_CTX* evp = nullptr;
+#else
+    QCryptographicHash qt{QCryptographicHash::Sha256};
+#endif
+#ifdef PLUGBACKUP_HAVE_BLAKE3
+    blake3_hasher b3;
+#endif
+#ifdef PLUGBACKUP_HAVE_XXHASH
+    XXH3_state_t* xxh = nullptr;
+#endif
+};
+
+Digest::Digest(Algo algo) : m_algo(effective(algo)), d(new State) {
+    switch (m_algo) {
+    case Algo::Sha256:
+#ifdef PLUGBACKUP_HAVE_OPENSSL
+        d->evp = EVP_MD_CTX_new();
+        if (d->evp) EVP_DigestInit_ex(d->evp, EVP_sha256(), nullptr);
+#endif
+        break;
+    case Algo::Blake3:
+#ifdef PLUGBACKUP_HAVE_BLAKE3
+        blake3_hasher_init(&d->b3);
+#endif
+        break;
+    case Algo::Xxh128:
+#ifdef PLUGBACKUP_HAVE_XXHASH
+        d->xxh = XXH3_createState();
+        if (d->xxh) XXH3_128bits_reset(d->xxh);
+#endif
+        break;
+    }
+}
+
+Digest::~Digest() {
+#ifdef PLUGBACKUP_HAVE_OPENSSL
+    if (d->evp) EVP_MD_CTX_free(d->evp);
+#endif
+#ifdef PLUGBACKUP_HAVE_XXHASH
+    if (d->xxh) XXH3_freeState(d->xxh);
+#endif
+}
+
+void Digest::addData(const char* data, qint64 len) {
+    if (len <= 0) return;
+    switch (m_algo) {
+    case Algo::Sha256:
+#ifdef PLUGBACKUP_HAVE_OPENSSL
+        if (d->evp) EVP_DigestUpdate(d->evp, data, size_t(len));
+#elif QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+        d->qt.addData(QByteArrayView(data, static_cast<qsizetype>(len)));
+#else
+        d->qt.addData(data, int(len));
+#endif
+        break;
+    case Algo::Blake3:
+#ifdef PLUGBACKUP_HAVE_BLAKE3
+        blake3_hasher_update(&d->b3, data, size_t(len));
+#endif
+        break;
+    case Algo::Xxh128:
+#ifdef PLUGBACKUP_HAVE_XXHASH
+        if (d->xxh) XXH3_128bits_update(d->xxh, data, size_t(len));
+#endif
+        break;
+    }
+}
+
+QByteArray Digest::result() {
+    switch (m_algo) {
+    case Algo::Sha256: {
+#ifdef PLUGBACKUP_HAVE_OPENSSL
+        if (!d->evp) return {};
+        unsigned char md[EVP_MAX_MD_SIZE];
+        unsigned int n = 0;
+        if (EVP_DigestFinal_ex(d->evp, md, &n) != 1) return {};
+        return QByteArray(reinterpret_cast<const char*>(md), int(n));
+#else
+        return d->qt.result();
+#endif
+    }
+    case Algo::Blake3: {
+#ifdef PLUGBACKUP_HAVE_BLAKE3
+        QByteArray out(BLAKE3_OUT_LEN, Qt::Uninitialized);
+        blake3_hasher_finalize(&d->b3, reinterpret_cast<uint8_t*>(out.data()), BLAKE3_OUT_LEN);
+        return out;
+#else
+        return {};
+#endif
+    }
+    case Algo::Xxh128: {
+#ifdef PLUGBACKUP_HAVE_XXHASH
+        if (!d->xxh) return {};
+        XXH128_canonical_t c;
+        XXH128_canonicalFromHash(&c, XXH3_128bits_digest(d->xxh)); // 大端规范形式，跨平台一致
+        return QByteArray(reinterpret_cast<const char*>(c.digest), int(sizeof(c.digest)));
+#else
+        return {};
+#endif
+    }
+    }
+    return {};
+}
+
+bool Digest::available(Algo algo) {
+    switch (algo) {
+    case Algo::Sha256: return true;
+#ifdef PLUGBACKUP_HAVE_BLAKE3
+    case Algo::Blake3: return true;
+#endif
+#ifdef PLUGBACKUP_HAVE_XXHASH
+    case Algo::Xxh128: return true;
+#endif
+    default:           return false;
+    }
+}
+
+Digest::Algo Digest::effective(Algo algo) {
+    return available(algo) ? algo : Algo::Sha256;
+}
+
+QString Digest::name(Algo algo) {
+    switch (algo) {
+    case Algo::Sha256: return QStringLiteral("sha256");
+    case Algo::Blake3: return QStringLiteral("blake3");
+    case Algo::Xxh128: return QStringLiteral("xxh128");
+    }
+    return QString();
+}
+
+bool Digest::fromName(const QString& name, Algo* out) {
+    const QString n = name.trimmed().toLower();
+    if      (n == "sha256" || n == "sha-256") *out = Algo::Sha256;
+    else if (n == "blake3")                   *out = Algo::Blake3;
+    else if (n == "xxh128" || n == "xxh3")    *out = Algo::Xxh128;
+    else return false;
+    return true;
+}
+
+QString Digest::backend(Algo algo) {
+    switch (effective(algo)) {
+    case Algo::Sha256:
+#ifdef PLUGBACKUP_HAVE_OPENSSL
+        return QStringLiteral("SHA-256 (OpenSSL)");
+#else
+        return QStringLiteral("SHA-256 (Qt)");
+#endif
+    case Algo::Blake3: return QStringLiteral("BLAKE3 (libblake3)");
+    case Algo::Xxh128: return QStringLiteral("XXH3-128 (libxxhash)");
+    }
+    return QString();
+}
+
+TreeDigest::TreeDigest(Digest::Algo algo) : m_algo(Digest::effective(algo)) {}
+TreeDigest::~TreeDigest() = default;
+
+void TreeDigest::addData(const char* data, qint64 len) {
+    while (len > 0) {
+        if (!m_cur) { m_cur.reset(new Digest(m_algo)); m_curLen = 0; }
+        const qint64 n = qMin(len, kSegment - m_curLen);
+        m_cur->addData(data, n);
+        data += n; len -= n; m_curLen += n;
+        if (m_curLen == kSegment) { m_segments.append(m_cur->result()); m_cur.reset(); }
+    }
+}
+
+QByteArray TreeDigest::result() {
+    if (m_cur) { m_segments.append(m_cur->result()); m_cur.reset(); }
+    if (m_segments.isEmpty()) m_segments.append(Digest(m_algo).result()); // 空文件
+    return combine(m_algo, m_segments);
+}
+
+QByteArray TreeDigest::combine(Digest::Algo algo, const QVector<QByteArray>& segments) {
+    if (segments.size() == 1) return segments.first();
+    Digest d(algo);
+    for (const QByteArray& s : segments) {
+        if (s.isEmpty()) return {};                         // 有段没算出来
+        d.addData(s.constData(), s.size());
+    }
+    return d.result();
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <memory>
+
+/**
+ * @brief 内容摘要的统一入口：复制时的源摘要、写后校验、文件索引都经由这里
+ * - Sha256：默认；构建时找到 OpenSSL 则走 libcrypto（自动用 SHA-NI / ARMv8 加密扩展），否则 QCryptographicHash
+ * - Blake3：需构建时找到 libblake3（SIMD 按 CPU 自动分派），强度与 SHA-256 同级、快数倍
+ * - Xxh128：需构建时找到 libxxhash（XXH3 128 位），只防意外损坏、不抗篡改，最快
+ * 选中的算法未编译进来时 effective() 退回 SHA-256。分块存储的块 ID 与增量复制的块签名不走这里，固定 SHA-256。
+ */
+class Digest {
+public:
+    enum class Algo : quint8 { Sha256 = 0, Blake3 = 1, Xxh128 = 2 };
+
+    explicit Digest(Algo algo);
+    ~Digest();
+    Digest(const Digest&) = delete;
+    Digest& operator=(const Digest&) = delete;
+
+    Algo algo() const { return m_algo; }
+    void addData(const char* data, qint64 len);
+    QByteArray result();                        // 结束并返回原始摘要字节；之后不能再 addData
+
+    static bool    available(Algo algo);        // 本次构建是否带有该算法
+    static Algo    effective(Algo algo);        // 不可用 → Sha256
+    static QString name(Algo algo);             // 写入元数据 JSON / 配置文件的名字："sha256" / "blake3" / "xxh128"
+    static bool    fromName(const QString& name, Algo* out);
+    static QString backend(Algo algo);          // 实际实现（用于日志）
+
+private:
+    struct State;
+    Algo                   m_algo;
+    std::unique_ptr<State> d;
+};
+
+/**
+ * @brief 分段树摘要：按 kSegment 切段，各段独立求 Digest，根 = H(各段摘要依次拼接)
+ * 只有一段（≤ kSegment）时根就是该段摘要，与整文件 Digest 相同；小文件的摘要因此不变。
+ * 复制时顺序喂入（本类）与校验时多线程按段并行计算（BackupWorker::fileHash）得到同一个根，
+ * 根不一致时逐段比对即可定位坏段，只重写这些段。
+ */
+class TreeDigest {
+public:
+    static constexpr qint64 kSegment = 64LL * 1024 * 1024;
+
+    explicit TreeDigest(Digest::Algo algo);
+    ~TreeDigest();
+    TreeDigest(const TreeDigest&) = delete;
+    TreeDigest& operator=(const TreeDigest&) = delete;
+
+    Digest::Algo algo() const { return m_algo; }
+    void addData(const char* data, qint64 len);             // 顺序喂入，段边界自动切分
+    QByteArray result();                                    // 结束；之后 segments() 为各段摘要
+    const QVector<QByteArray>& segments() const { return m_segments; }
+
+    static QByteArray combine(Digest::Algo algo, const QVector<QByteArray>& segments);
+
+private:
+    Digest::Algo            m_algo;
+    std::unique_ptr<Digest> m_cur;                          // 当前段；满段或 result() 时结束
+    qint64                  m_curLen = 0;
+    QVector<QByteArray>     m_segments;
+};
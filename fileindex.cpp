@@ -0,0 +1,124 @@
+#include "fileindex.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
+
+#include <utility>
+
+static const quint32 kIndexMagic   = 0x50424958; // "PBIX"
+static const quint32 kIndexVersion = 4; // 2：每条记录带摘要算法（1 均为 SHA-256）；3：大文件摘要改为分段树形式；4：头部带标志（覆盖目标）
+static const quint8  kFlagCoversDest = 0x01;
+
+FileIndex::FileIndex(QString path) : m_path(std::move(path)) {}
+
+bool FileIndex::load() {
+    m_map.clear();
+    m_dirty = false;
+    m_coversDest = false;
+    if (m_path.isEmpty()) return false;
+
+    QFile f(m_path);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    QDataStream in(&f);
+    in.setVersion(QDataStream::Qt_5_15);
+
+    quint32 magic = 0, ver = 0, count = 0;
+    quint8  flags = 0;
+    in >> magic >> ver;
+    if (magic != kIndexMagic || ver < 1 || ver > kIndexVersion) return false;
+    if (ver >= 4) in >> flags;                         // 旧索引不知道目标上还有哪些文件 → 先遍历一次
+    in >> count;
+
+    m_map.reserve(qsizetype(count));
+    for (quint32 i = 0; i < count; ++i) {
+        QString rel; Entry e;
+        in >> rel >> e.size >> e.mtimeMs >> e.fileId >> e.digest;
+        if (ver >= 2) {
+            quint8 algo = 0;
+            in >> algo;
+            e.digestAlgo = Digest::Algo(algo);
+        }
+        if (ver < 3 && e.size > TreeDigest::kSegment) e.digest.clear(); // 旧的整文件摘要与分段树根不可比
+        if (in.status() != QDataStream::Ok) { m_map.clear(); return false; } // 损坏 → 当作没有索引
+        m_map.insert(rel, e);
+    }
+    m_coversDest = (flags & kFlagCoversDest) != 0;
+    return true;
+}
+
+bool FileIndex::save() {
+    if (!m_dirty || m_path.isEmpty()) return true;
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+
+    QSaveFile f(m_path);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    QDataStream out(&f);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << kIndexMagic << kIndexVersion << quint8(m_coversDest ? kFlagCoversDest : 0) << quint32(m_map.size());
+    for (auto it = m_map.cbegin(); it != m_map.cend(); ++it) {
+        const Entry& e = it.value();
+        out << it.key() << e.size << e.mtimeMs << e.fileId << e.digest << quint8(e.digestAlgo);
+    }
+    if (out.status() != QDataStream::Ok || !f.commit()) return false;
+    m_dirty = false;
+    return true;
+}
+
+const FileIndex::Entry* FileIndex::find(const QString& rel) const {
+    auto it = m_map.constFind(rel);
+    return it == m_map.cend() ? nullptr : &it.value();
+}
+
+bool FileIndex::matches(const QString& rel, const FileStat& st) const {
+    if (!st.exists || !st.isFile) return false;
+    const Entry* e = find(rel);
+    if (!e) return false;
+    if (e->size != st.size || e->mtimeMs != st.mtimeMs) return false;
+    // 文件 ID 只在两边都取得到时比较（Windows 上为 0）
+    if (e->fileId != 0 && st.fileId != 0 && e->fileId != st.fileId) return false;
+    return true;
+}
+
+void FileIndex::put(const QString& rel, const Entry& e) {
+    m_map.insert(rel, e);
+    m_dirty = true;
+}
+
+void FileIndex::remove(const QString& rel) {
+    if (m_map.remove(rel)) m_dirty = true;
+}
+
+void FileIndex::invalidate(const QString& rel) {
+    Entry e;
+    e.size = -1;                                       // 与任何 stat 都对不上，也不提供摘要
+    m_map.insert(rel, e);
+    m_dirty = true;
+}
+
+void FileIndex::markPresent(const QString& rel) {
+    if (m_map.contains(rel)) return;
+    invalidate(rel);
+}
+
+void FileIndex::setCoversDest(bool on) {
+    if (m_coversDest == on) return;
+    m_coversDest = on;
+    m_dirty = true;
+}
+
+QStringList FileIndex::relsNotIn(const PathTable& keep) const {
+    QStringList out;
+    for (auto it = m_map.cbegin(); it != m_map.cend(); ++it)
+        if (!keep.contains(it.key())) out << it.key();
+    return out;
+}
+
+void FileIndex::retainOnly(const PathTable& keep) {
+    for (auto it = m_map.begin(); it != m_map.end(); ) {
+        if (!keep.contains(it.key())) { it = m_map.erase(it); m_dirty = true; }
+        else ++it;
+    }
+}
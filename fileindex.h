@@ -0,0 +1,53 @@
+#pragma once
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QStringList>
+
+#include "FileStat.h"
+#include "PathTable.h"
+#include "digest.h"
+
+/**
+ * @brief 每个命名空间一份的持久化文件索引（存放于目标盘）
+ * 路径：dst/.plugbackup_meta/index/<ns>/files.idx
+ * 记录“上次成功备份时”源文件的 size/mtime/文件ID 以及内容摘要（连同所用算法），
+ * 源文件 stat 与记录一致即可判定未变化：不读源内容、不碰目标文件。
+ * coversDest() 为真时它同时是目标清单：dst/<ns> 下我们写过的每个文件都有一条记录
+ * （复制前先 invalidate() 成占位记录，失败也不丢），删除判定只需拿它与本轮扫描比对，不必遍历目标。
+ */
+class FileIndex {
+public:
+    struct Entry {
+        qint64     size    = 0;
+        qint64     mtimeMs = 0;
+        quint64    fileId  = 0;
+        QByteArray digest;       // 可能为空（例如未开启写后校验）
+        Digest::Algo digestAlgo = Digest::Algo::Sha256; // 换了算法的记录不能拿来比对
+    };
+
+    explicit FileIndex(QString path = QString());
+
+    bool load();        // 文件不存在/损坏 → 空索引，返回 false
+    bool save();        // QSaveFile 原子写入；未修改则直接返回 true
+
+    const Entry* find(const QString& rel) const;
+    bool matches(const QString& rel, const FileStat& st) const; // 源未变化？
+    void put(const QString& rel, const Entry& e);
+    void remove(const QString& rel);
+    void invalidate(const QString& rel);                        // 改成占位记录：目标上有此文件，内容未登记
+    void markPresent(const QString& rel);                       // 没有记录时补一条占位
+    void retainOnly(const PathTable& keep);                     // 清理已不存在于源的记录
+    QStringList relsNotIn(const PathTable& keep) const;         // 有记录而本轮源中没有的路径
+
+    bool coversDest() const { return m_coversDest; }
+    void setCoversDest(bool on);
+
+    int  size() const { return int(m_map.size()); }
+
+private:
+    QString                m_path;
+    QHash<QString, Entry>  m_map;
+    bool                   m_dirty = false;
+    bool                   m_coversDest = false;            // 记录覆盖目标上的全部文件（可当目标清单用）
+};
@@ -0,0 +1,132 @@
+#include "iouring.h"
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static int sysSetup(unsigned entries, io_uring_params* p) {
+    return int(::syscall(__NR_io_uring_setup, entries, p));
+}
+static int sysEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return int(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+static int sysRegister(int fd, unsigned op, const void* arg, unsigned count) {
+    return int(::syscall(__NR_io_uring_register, fd, op, arg, count));
+}
+
+IoUring::~IoUring() {
+    if (m_sqes) ::munmap(m_sqes, m_sqesSize);
+    if (m_cqRing && m_cqRing != m_sqRing) ::munmap(m_cqRing, m_cqRingSize);
+    if (m_sqRing) ::munmap(m_sqRing, m_sqRingSize);
+    if (m_fd >= 0) ::close(m_fd);
+}
+
+bool IoUring::init(unsigned entries) {
+    io_uring_params p;
+    std::memset(&p, 0, sizeof(p));
+    m_fd = sysSetup(entries, &p);
+    if (m_fd < 0) return false;
+
+    m_sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    m_cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    const bool single = p.features & IORING_FEAT_SINGLE_MMAP; // 5.4+：SQ/CQ 环共用一次映射
+    if (single) m_sqRingSize = m_cqRingSize = qMax(m_sqRingSize, m_cqRingSize);
+
+    m_sqRing = ::mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+    if (m_sqRing == MAP_FAILED) { m_sqRing = nullptr; return false; }
+    if (single) {
+        m_cqRing = m_sqRing;
+    } else {
+        m_cqRing = ::mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+        if (m_cqRing == MAP_FAILED) { m_cqRing = nullptr; return false; }
+    }
+    m_sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) return false;
+    m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(m_sqRing);
+    m_sqHead    = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+    m_sqTail    = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+    m_sqArray   = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+    m_sqMask    = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+    m_sqEntries = p.sq_entries;
+    m_localTail = *m_sqTail;
+
+    char* cq = static_cast<char*>(m_cqRing);
+    m_cqHead = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+    m_cqTail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+    m_cqMask = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+    m_cqes   = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+    return true;
+}
+
+bool IoUring::registerBuffers(const iovec* iov, unsigned count) {
+    m_fixedBuffers = m_fd >= 0 && sysRegister(m_fd, IORING_REGISTER_BUFFERS, iov, count) == 0;
+    return m_fixedBuffers;
+}
+
+io_uring_sqe* IoUring::nextSqe() {
+    const unsigned head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+    if (m_localTail - head >= m_sqEntries) return nullptr;
+    const unsigned idx = m_localTail & m_sqMask;
+    io_uring_sqe* sqe = &m_sqes[idx];
+    std::memset(sqe, 0, sizeof(*sqe));
+    m_sqArray[idx] = idx;
+    ++m_localTail;
+    ++m_pending;
+    return sqe;
+}
+
+bool IoUring::prepRead(int fd, void* buf, unsigned len, quint64 offset, int bufIndex, quint64 userData) {
+    io_uring_sqe* sqe = nextSqe();
+    if (!sqe) return false;
+    const bool fixed = m_fixedBuffers && bufIndex >= 0;
+    sqe->opcode    = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    sqe->fd        = fd;
+    sqe->addr      = reinterpret_cast<quint64>(buf);
+    sqe->len       = len;
+    sqe->off       = offset;
+    sqe->buf_index = fixed ? quint16(bufIndex) : 0;
+    sqe->user_data = userData;
+    return true;
+}
+
+bool IoUring::prepWrite(int fd, const void* buf, unsigned len, quint64 offset, int bufIndex, quint64 userData) {
+    io_uring_sqe* sqe = nextSqe();
+    if (!sqe) return false;
+    const bool fixed = m_fixedBuffers && bufIndex >= 0;
+    sqe->opcode    = fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe->fd        = fd;
+    sqe->addr      = reinterpret_cast<quint64>(buf);
+    sqe->len       = len;
+    sqe->off       = offset;
+    sqe->buf_index = fixed ? quint16(bufIndex) : 0;
+    sqe->user_data = userData;
+    return true;
+}
+
+int IoUring::submitAndWait(unsigned waitNr) {
+    __atomic_store_n(m_sqTail, m_localTail, __ATOMIC_RELEASE);
+    int r;
+    do {
+        r = sysEnter(m_fd, m_pending, waitNr, waitNr ? IORING_ENTER_GETEVENTS : 0u);
+    } while (r < 0 && errno == EINTR);
+    if (r < 0) return -errno;
+    m_pending -= qMin(unsigned(r), m_pending);
+    return r;
+}
+
+bool IoUring::popCompletion(quint64* userData, int* res) {
+    const unsigned head = *m_cqHead; // 只有本线程消费
+    if (head == __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE)) return false;
+    const io_uring_cqe& c = m_cqes[head & m_cqMask];
+    *userData = c.user_data;
+    *res      = c.res;
+    __atomic_store_n(m_cqHead, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+#include <QtGlobal>
+
+#ifdef Q_OS_LINUX
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+/**
+ * @brief 最小化的 io_uring 封装：直接走系统调用，不依赖 liburing
+ * 只覆盖复制用到的部分：提交/完成队列、注册缓冲、READ(_FIXED)/WRITE(_FIXED)。
+ * 单线程使用；析构时关闭 ring（在途请求由内核取消）——调用方应先收齐完成项再释放缓冲。
+ */
+class IoUring {
+public:
+    IoUring() = default;
+    ~IoUring();
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    bool init(unsigned entries);                            // 内核不支持或被 sysctl 禁用 → false
+    bool registerBuffers(const iovec* iov, unsigned count); // RLIMIT_MEMLOCK 不够时失败，仍可用普通读写
+
+    // 准备一个请求；bufIndex >= 0 且已注册缓冲时用 *_FIXED。提交队列满返回 false
+    bool prepRead(int fd, void* buf, unsigned len, quint64 offset, int bufIndex, quint64 userData);
+    bool prepWrite(int fd, const void* buf, unsigned len, quint64 offset, int bufIndex, quint64 userData);
+
+    int  submitAndWait(unsigned waitNr);                    // 提交已准备的请求并至少等 waitNr 个完成；出错返回 -errno
+    bool popCompletion(quint64* userData, int* res);        // 取一个完成项；暂无返回 false
+
+private:
+    io_uring_sqe* nextSqe();
+
+    int       m_fd = -1;
+    void*     m_sqRing = nullptr;
+    void*     m_cqRing = nullptr;
+    size_t    m_sqRingSize = 0;
+    size_t    m_cqRingSize = 0;
+    io_uring_sqe* m_sqes = nullptr;
+    size_t    m_sqesSize = 0;
+
+    unsigned* m_sqHead = nullptr;
+    unsigned* m_sqTail = nullptr;
+    unsigned* m_sqArray = nullptr;
+    unsigned  m_sqMask = 0;
+    unsigned  m_sqEntries = 0;
+    unsigned  m_localTail = 0;                              // 已准备、未发布给内核的尾
+    unsigned  m_pending = 0;                                // 已准备、未被内核取走的数量
+
+    unsigned* m_cqHead = nullptr;
+    unsigned* m_cqTail = nullptr;
+    unsigned  m_cqMask = 0;
+    io_uring_cqe* m_cqes = nullptr;
+
+    bool      m_fixedBuffers = false;
+};
+#endif
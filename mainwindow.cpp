@@ -1,6 +1,11 @@
-#include "MainWindow.h"
-#include "BackupWorker.h"
+#include "mainwindow.h"
+#include "backupworker.h"
 #include "SpeedAverager.h"
+#include "chunkstore.h"
+#include "recordlistmodel.h"
+#include "recursivewatcher.h"
+#include "treewalker.h"
+#include "vaultcatalog.h"
 
 #include <QScrollArea>
 #include <QComboBox>
@@ -13,15 +18,17 @@
 #include <QHBoxLayout>
 #include <QGridLayout>
 #include <QGroupBox>
+#include <QListView>
 #include <QListWidget>
 #include <QPushButton>
 #include <QLineEdit>
 #include <QLabel>
 #include <QFileDialog>
 #include <QDir>
-#include <QDirIterator>
 #include <QFileInfo>
+#include <QSet>
 #include <QSettings>
+#include <QSignalBlocker>
 #include <QStatusBar>
 #include <QMessageBox>
 #include <QTableWidget>
@@ -32,12 +39,12 @@
 #include <QDateTime>
 #include <QCheckBox>
 #include <QSpinBox>
-#include <QFileSystemWatcher>
 #include <QStorageInfo>
 #include <QToolButton>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QRegularExpression>
+#include <QHash>
 
 #include <algorithm>
 #include <utility>
@@ -201,6 +208,46 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
         m_spinSmartPollSec->setValue(5);
         g->addWidget(m_spinSmartPollSec, 2,3);
 
+        // 并行复制
+        g->addWidget(new QLabel(tr("并行复制数（小文件多时可调大）"), box), 3,0);
+        m_spinCopyLanes = new QSpinBox(box);
+        m_spinCopyLanes->setRange(1, 16);
+        m_spinCopyLanes->setValue(2);
+        g->addWidget(m_spinCopyLanes, 3,1);
+
+        // 分块去重存储
+        m_chkChunkStore = new QCheckBox(tr("历史版本/删除留存使用分块去重存储（大文件小改动更省空间）"), box);
+        g->addWidget(m_chkChunkStore, 4,0,1,4);
+
+        // 增量复制
+        m_chkDelta = new QCheckBox(tr("大文件增量复制：只改写变化的块（减少对U盘的写入）"), box);
+        g->addWidget(m_chkDelta, 5,0,1,4);
+
+        // 写后校验
+        m_chkVerify = new QCheckBox(tr("复制后校验（关闭后 Linux 上可走内核零拷贝，更省 CPU）"), box);
+        m_chkVerify->setChecked(true);
+        g->addWidget(m_chkVerify, 6,0,1,4);
+
+        // 摘要算法（复制时源摘要 / 写后校验 / 索引比对）；只列本次构建带有的
+        g->addWidget(new QLabel(tr("校验摘要算法"), box), 7,0);
+        m_comboHashAlgo = new QComboBox(box);
+        m_comboHashAlgo->addItem(tr("SHA-256（默认）"), int(Digest::Algo::Sha256));
+        if (Digest::available(Digest::Algo::Blake3))
+            m_comboHashAlgo->addItem(tr("BLAKE3（更快，强度相同）"), int(Digest::Algo::Blake3));
+        if (Digest::available(Digest::Algo::Xxh128))
+            m_comboHashAlgo->addItem(tr("XXH3-128（最快，仅防意外损坏）"), int(Digest::Algo::Xxh128));
+        g->addWidget(m_comboHashAlgo, 7,1,1,3);
+
+        // 留存策略：天数窗口内的全留，稀疏再从更旧的版本里按档挑；版本数为总上限
+        g->addWidget(new QLabel(tr("每个文件最多保留版本数（0=不限）"), box), 8,0);
+        m_spinKeepVersions = new QSpinBox(box);
+        m_spinKeepVersions->setRange(0, 1000);
+        m_spinKeepVersions->setValue(0);
+        g->addWidget(m_spinKeepVersions, 8,1);
+
+        m_chkThinVersions = new QCheckBox(tr("稀疏旧版本：超出保留天数后仍按最近 24 小时每小时、30 天每天、52 周每周各留最新一份"), box);
+        g->addWidget(m_chkThinVersions, 9,0,1,4);
+
         vbox->addWidget(box);
 
         connect(m_chkSmart,        &QCheckBox::toggled, this, &MainWindow::onAutoOptionsChanged);
@@ -208,6 +255,13 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
         connect(m_spinSmartPollSec,qOverload<int>(&QSpinBox::valueChanged), this, &MainWindow::onAutoOptionsChanged);
         connect(m_spinRetentionDays,qOverload<int>(&QSpinBox::valueChanged), this, &MainWindow::onAutoOptionsChanged);
         connect(m_spinSpeedLimitMB,qOverload<int>(&QSpinBox::valueChanged), this, &MainWindow::onAutoOptionsChanged);
+        connect(m_spinCopyLanes,   qOverload<int>(&QSpinBox::valueChanged), this, &MainWindow::onAutoOptionsChanged);
+        connect(m_chkChunkStore,   &QCheckBox::toggled, this, &MainWindow::onAutoOptionsChanged);
+        connect(m_chkDelta,        &QCheckBox::toggled, this, &MainWindow::onAutoOptionsChanged);
+        connect(m_chkVerify,       &QCheckBox::toggled, this, &MainWindow::onAutoOptionsChanged);
+        connect(m_spinKeepVersions,qOverload<int>(&QSpinBox::valueChanged), this, &MainWindow::onAutoOptionsChanged);
+        connect(m_chkThinVersions, &QCheckBox::toggled, this, &MainWindow::onAutoOptionsChanged);
+        connect(m_comboHashAlgo,   qOverload<int>(&QComboBox::currentIndexChanged), this, &MainWindow::onAutoOptionsChanged);
     }
 
     // —— 任务表（增加“操作”列） —— //
@@ -221,7 +275,10 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     // —— 失败面板 —— //
     {
         auto *row = new QHBoxLayout();
-        m_failedList = new QListWidget(page);
+        m_failedModel = new RecordListModel(RecordListModel::Kind::Failure, this);
+        m_failedList = new QListView(page);
+        m_failedList->setModel(m_failedModel);
+        m_failedList->setUniformItemSizes(true);   // 行高一致：视图不必逐行测量
         m_failedList->setMinimumHeight(80);
         m_btnRetryFailed = new QPushButton(tr("只重试失败"), page);
         row->addWidget(new QLabel(tr("失败文件："), page));
@@ -236,10 +293,28 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
         auto *box = new QGroupBox(tr("历史版本 与 删除留存（来自 .plugbackup_meta）"), page);
         auto *g = new QGridLayout(box);
 
-        m_versionsList = new QListWidget(box);
-        m_deletedList  = new QListWidget(box);
-        m_versionsList->setMinimumHeight(120);
-        m_deletedList->setMinimumHeight(120);
+        m_versionsModel = new RecordListModel(RecordListModel::Kind::Vault, this);
+        m_deletedModel  = new RecordListModel(RecordListModel::Kind::Vault, this);
+        m_versionsList = new QListView(box);
+        m_deletedList  = new QListView(box);
+        m_versionsList->setModel(m_versionsModel);
+        m_deletedList->setModel(m_deletedModel);
+        for (QListView* v : {m_versionsList, m_deletedList}) {
+            v->setUniformItemSizes(true);
+            v->setMinimumHeight(120);
+        }
+
+        // 筛选：两个列表共用
+        m_vaultPrefix = new QLineEdit(box);
+        m_vaultPrefix->setPlaceholderText(tr("按相对路径前缀筛选，如 docs/2024/"));
+        m_vaultNs = new QComboBox(box);
+        m_vaultNs->addItem(tr("全部命名空间"), QString());
+        m_vaultAge = new QComboBox(box);
+        m_vaultAge->addItem(tr("全部时间"),      0);
+        m_vaultAge->addItem(tr("最近 24 小时"),  1);
+        m_vaultAge->addItem(tr("最近 7 天"),     7);
+        m_vaultAge->addItem(tr("最近 30 天"),    30);
+        m_vaultAge->addItem(tr("30 天以前"),    -30);
 
         m_btnScanVault       = new QPushButton(tr("扫描"), box);
         m_btnRestoreVersion  = new QPushButton(tr("恢复历史版本到源"), box);
@@ -248,6 +323,13 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
         int r=0;
         g->addWidget(new QLabel(tr("历史版本"), box), r,0);
         g->addWidget(m_btnScanVault, r,1); ++r;
+        {
+            auto *filterRow = new QHBoxLayout();
+            filterRow->addWidget(m_vaultPrefix, 1);
+            filterRow->addWidget(m_vaultNs);
+            filterRow->addWidget(m_vaultAge);
+            g->addLayout(filterRow, r,0,1,2); ++r;
+        }
         g->addWidget(m_versionsList, r,0,1,2); ++r;
         g->addWidget(new QLabel(tr("删除留存"), box), r,0); ++r;
         g->addWidget(m_deletedList, r,0,1,2); ++r;
@@ -263,6 +345,11 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
         connect(m_btnScanVault,      &QPushButton::clicked, this, &MainWindow::onScanVault);
         connect(m_btnRestoreVersion, &QPushButton::clicked, this, &MainWindow::onRestoreSelectedVersion);
         connect(m_btnRestoreDeleted, &QPushButton::clicked, this, &MainWindow::onRestoreSelectedDeleted);
+        connect(m_vaultPrefix, &QLineEdit::textChanged, this, [this]{ applyVaultFilter(); });
+        connect(m_vaultNs,  qOverload<int>(&QComboBox::currentIndexChanged), this, [this]{ applyVaultFilter(); });
+        connect(m_vaultAge, qOverload<int>(&QComboBox::currentIndexChanged), this, [this]{ applyVaultFilter(); });
+        connect(m_versionsModel, &RecordListModel::groupsChanged, this, &MainWindow::refreshVaultNamespaces);
+        connect(m_deletedModel,  &RecordListModel::groupsChanged, this, &MainWindow::refreshVaultNamespaces);
     }
 
     // —— 操作区 —— //
@@ -301,9 +388,9 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     connect(m_sourceList, &QListWidget::itemSelectionChanged, this, &MainWindow::onValidate);
 
     // —— 监控 + 定时器 —— //
-    m_watcher      = new QFileSystemWatcher(this);
-    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &MainWindow::onWatchedPathChanged);
-    connect(m_watcher, &QFileSystemWatcher::fileChanged,      this, &MainWindow::onWatchedPathChanged);
+    m_watcher      = new RecursiveWatcher(this);
+    connect(m_watcher, &RecursiveWatcher::changed,    this, &MainWindow::onWatchedChanged);
+    connect(m_watcher, &RecursiveWatcher::overflowed, this, &MainWindow::onWatchOverflow);
 
     m_timerDevice  = new QTimer(this);
     connect(m_timerDevice, &QTimer::timeout, this, &MainWindow::onDeviceCheckTick);
@@ -318,6 +405,10 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
     m_timerSmart   = new QTimer(this);
     connect(m_timerSmart, &QTimer::timeout, this, &MainWindow::onSmartTick);
 
+    m_timerProgress = new QTimer(this);
+    m_timerProgress->setInterval(250);
+    connect(m_timerProgress, &QTimer::timeout, this, &MainWindow::onProgressTick);
+
     // 统一留白
     page->layout()->setContentsMargins(12,12,12,12);
     page->layout()->setSpacing(10);
@@ -508,6 +599,30 @@ void MainWindow::addOpButtons(int row) {
     btnResume->setIcon(style()->standardIcon(QStyle::SP_MediaPlay));
     btnCancel->setIcon(style()->standardIcon(QStyle::SP_DialogCancelButton));
 }
+// 进度不随信号推送：定时读取各任务的计数快照
+void MainWindow::onProgressTick() {
+    bool any = false;
+    for (const Task& t : std::as_const(m_tasks)) {
+        if (!t.progress) continue;
+        applyProgress(t.row, *t.progress);
+        any = true;
+    }
+    updateGlobalStats();
+    if (!any) m_timerProgress->stop();
+}
+void MainWindow::applyProgress(int row, const BackupProgress& progress) {
+    const BackupProgress::Snapshot s = progress.snapshot();
+    if (auto *bar = qobject_cast<QProgressBar*>(m_jobs->cellWidget(row,2))) {
+        const int pct = s.bytesTotal>0 ? int((s.bytesDone*100)/qMax<qint64>(s.bytesTotal,1)) : 0;
+        bar->setValue(pct);
+        bar->setFormat(tr("%1%  (%2 / %3 MB · %4 / %5 个文件)").arg(pct)
+                       .arg(s.bytesDone/1024/1024).arg(s.bytesTotal/1024/1024).arg(s.filesDone).arg(s.filesTotal));
+    }
+    m_jobs->item(row,3)->setText(humanSpeed(s.bytesPerSec));
+    m_jobs->item(row,4)->setText(humanEta(s.etaSec));
+    m_rowSpeedBps[row]    = s.bytesPerSec;
+    m_rowRemainBytes[row] = qMax<qint64>(s.bytesTotal - s.bytesDone, 0);
+}
 void MainWindow::updateGlobalStats() {
     double totalBps = 0.0; qint64 totalRemain = 0;
     for (int i=0;i<m_jobs->rowCount();++i) { totalBps += m_rowSpeedBps.value(i,0.0); totalRemain += m_rowRemainBytes.value(i,0); }
@@ -528,14 +643,30 @@ void MainWindow::onStartBackup() {
     const QString dst = m_destEdit->text();
     if (srcs.isEmpty() || dst.isEmpty()) return;
 
-    // 粗略空间预检（未考虑去重/版本）
+    // 监听触发且日志完整 → 增量运行：只扫描有改动的目录，没有改动的源直接跳过
+    const bool incremental = m_runFromJournal && !m_journal.needsFullScan();
+    m_runFromJournal = false;
+    QHash<QString, QPair<QStringList, QStringList>> scopes; // src → (单层目录, 整棵目录)
+    if (incremental) {
+        QStringList touched;
+        for (const QString& src : std::as_const(srcs)) {
+            QStringList dirs, trees;
+            if (!m_journal.scopeFor(src, &dirs, &trees)) continue;
+            scopes.insert(src, qMakePair(dirs, trees));
+            touched << src;
+        }
+        srcs = touched;
+        if (srcs.isEmpty()) { m_journal.reset(); return; }
+    }
+
+    // 粗略空间预检（未考虑去重/版本）；增量运行只涉及少量文件，跳过整树遍历
     qint64 totalNeed = 0;
-    for (const QString& src : srcs) {
-        QDirIterator it(src, QDir::Files, QDirIterator::Subdirectories);
-        while (it.hasNext()) { it.next(); totalNeed += it.fileInfo().size(); }
+    if (!incremental) {
+        for (const QString& src : srcs)
+            TreeWalker::walk(src, {}, [&](TreeWalker::Entry& e){ totalNeed += e.st.size; return true; });
     }
     QStorageInfo st(dst);
-    if (st.isValid()) {
+    if (st.isValid() && !incremental) {
         qint64 avail = st.bytesAvailable();
         if (avail < totalNeed * 1.1) {
             if (QMessageBox::warning(this, tr("空间不足"),
@@ -548,31 +679,52 @@ void MainWindow::onStartBackup() {
     }
 
     m_backupRunning = true;
-    m_failedBySrc.clear();
-    m_failedList->clear();
+    m_journal.reset(); // 本轮已覆盖此前的改动；之后的事件记入新日志
+    m_failedModel->clear();
 
     const qint64 speedLimitBps = qint64(m_spinSpeedLimitMB->value()) * 1024 * 1024;
     const int    retentionDays = m_spinRetentionDays->value();
+    const int    copyLanes     = m_spinCopyLanes->value();
+    const bool   chunkStore    = m_chkChunkStore->isChecked();
+    const bool   delta         = m_chkDelta->isChecked();
+    const bool   verify        = m_chkVerify->isChecked();
+    const auto   hashAlgo      = Digest::Algo(m_comboHashAlgo->currentData().toInt());
+    const int    keepVersions  = m_spinKeepVersions->value();
+    const bool   thin          = m_chkThinVersions->isChecked();
 
     for (const auto& src : srcs) {
         const int row = addJobRow(src, dst);
 
         auto *worker = new BackupWorker({
             src, dst,
-            /*verify*/true, /*retries*/3,
+            /*verify*/verify, /*retries*/3,
             /*ignore*/ splitPatterns(m_ignoreEdit->text()),
             /*whitelist*/ {},
             /*speedLimit*/ speedLimitBps,
             /*keepVersionsOnChange*/ true,
             /*keepDeletedInVault*/   true,
-            /*retentionDays*/        retentionDays
+            /*retentionDays*/        retentionDays,
+            /*chunkStoreVault*/      chunkStore,
+            /*nsName*/               QString(),
+            /*copyLanes*/            copyLanes,
+            /*deltaTransfer*/        delta,
+            /*scopeDirs*/            scopes.value(src).first,
+            /*scopeTrees*/           scopes.value(src).second,
+            /*hashAlgo*/             hashAlgo,
+            /*keepVersions*/         keepVersions,
+            /*keepHourly*/           thin ? 24 : 0,
+            /*keepDaily*/            thin ? 30 : 0,
+            /*keepWeekly*/           thin ? 52 : 0,
+            /*allowMassDeletion*/    m_massDeletionOk.contains(src)
         });
+        m_massDeletionOk.remove(src);
 
         auto *th = new QThread(this);
         th->setObjectName(QStringLiteral("BackupWorker:%1").arg(src));
         worker->moveToThread(th);
 
-        Task tk; tk.src=src; tk.dst=dst; tk.worker=worker; tk.thread=th; tk.row=row; tk.paused=false;
+        const std::shared_ptr<BackupProgress> progress = worker->progress();
+        Task tk; tk.src=src; tk.dst=dst; tk.worker=worker; tk.thread=th; tk.row=row; tk.paused=false; tk.progress=progress;
         m_tasks.push_back(tk);
 
         // 启动
@@ -582,40 +734,17 @@ void MainWindow::onStartBackup() {
         connect(worker, &BackupWorker::deviceOffline, this, &MainWindow::onWorkerDeviceOffline);
         connect(worker, &BackupWorker::deviceOnline,  this, &MainWindow::onWorkerDeviceOnline);
 
-        // 进度/状态
+        // 状态/失败项（进度由 onProgressTick 定时读取）
         connect(worker, &BackupWorker::stateChanged, this, [=](const QString& s){ m_jobs->item(row,5)->setText(s); });
-        connect(worker, &BackupWorker::progressUpdated, this, [=](qint64 done, qint64 total){
-            auto *bar = qobject_cast<QProgressBar*>(m_jobs->cellWidget(row,2)); if(!bar) return;
-            int pct = total>0 ? int((done*100)/qMax<qint64>(total,1)) : 0;
-            bar->setValue(pct);
-            bar->setFormat(QString("%1%  (%2 / %3 MB)").arg(pct).arg(done/1024/1024).arg(total/1024/1024));
-            m_rowRemainBytes[row] = qMax<qint64>(total - done, 0);
-            updateGlobalStats();
-        });
-        connect(worker, &BackupWorker::speedUpdated, this, [=](double bps){
-            m_jobs->item(row,3)->setText(humanSpeed(bps));
-            m_rowSpeedBps[row] = bps; updateGlobalStats();
-        });
-        connect(worker, &BackupWorker::etaUpdated, this, [=](qint64 sec){ m_jobs->item(row,4)->setText(humanEta(sec)); });
-        connect(worker, &BackupWorker::fileFinished, this, [=](const QString& rel, bool ok, const QString& err){
-            if (!ok) {
-                m_failedBySrc[src] << rel;
-                m_failedList->addItem(src + " :: " + rel + " :: " + err);
-            }
-        });
-        connect(worker, &BackupWorker::versionCreated, this, [=](const QString&, const QString& path, const QString& meta){
-            auto *it = new QListWidgetItem(QFileInfo(path).fileName());
-            it->setToolTip(path);
-            it->setData(Qt::UserRole, path);
-            it->setData(Qt::UserRole+1, meta);
-            m_versionsList->addItem(it);
-        });
-        connect(worker, &BackupWorker::deletedStashed, this, [=](const QString&, const QString& path, const QString& meta){
-            auto *it = new QListWidgetItem(QFileInfo(path).fileName());
-            it->setToolTip(path);
-            it->setData(Qt::UserRole, path);
-            it->setData(Qt::UserRole+1, meta);
-            m_deletedList->addItem(it);
+        connectRecordSignals(worker, src);
+
+        // 删除项过多被暂缓：问一次是否确实删了，确认后下一轮照常移入删除留存
+        connect(worker, &BackupWorker::deletionsHeld, this, [=](int count){
+            if (QMessageBox::question(this, tr("删除项过多"),
+                                      tr("源目录 %1 中有 %2 个已备份的文件不见了，超过已备份文件的一半。\n"
+                                         "若是源盘没有接好，请检查后重新备份；若确实删除了，下次备份时把它们移入删除留存？")
+                                          .arg(src).arg(count)) == QMessageBox::Yes)
+                m_massDeletionOk.insert(src);
         });
 
         // !!! 正确的收口顺序：worker finished -> 线程 quit；对象 deleteLater 均在 finished 之后
@@ -626,8 +755,9 @@ void MainWindow::onStartBackup() {
         // UI 收尾（不负责删除对象）
         connect(worker, &BackupWorker::finished, this, [=](bool ok, const QString&){
             m_jobs->item(row,5)->setText(ok ? tr("完成") : tr("失败"));
-            m_rowSpeedBps[row] = 0.0; updateGlobalStats();
-            for (auto &t : m_tasks) if (t.row==row) { t.worker=nullptr; t.thread=nullptr; }
+            applyProgress(row, *progress); updateGlobalStats(); // 最终值；之后不再定时读取
+            if (!ok) m_journal.markLost(); // 本轮未覆盖的改动已无从得知 → 下次全量
+            for (auto &t : m_tasks) if (t.row==row) { t.worker=nullptr; t.thread=nullptr; t.progress.reset(); }
 
             bool anyRunning=false;
             for (int r=0;r<m_jobs->rowCount();++r) {
@@ -642,6 +772,7 @@ void MainWindow::onStartBackup() {
 
         th->start();
     }
+    m_timerProgress->start();
 }
 
 // ========== 行级操作 ==========
@@ -674,6 +805,7 @@ void MainWindow::onCancelRow() {
     int row = btn->property("row").toInt();
     for (auto &t : m_tasks) if (t.row==row && t.worker) {
             t.worker->requestStop();
+            t.cancelled = true;
             m_jobs->item(row,5)->setText(tr("取消中…"));
             auto *w = m_jobs->cellWidget(row,6);
             QList<QToolButton*> buttons = w->findChildren<QToolButton*>();
@@ -684,13 +816,22 @@ void MainWindow::onCancelRow() {
 
 // ========== 失败重试 ==========
 void MainWindow::onRetryFailed() {
-    if (m_failedBySrc.isEmpty()) { QMessageBox::information(this, tr("提示"), tr("没有失败文件需要重试。")); return; }
+    const QMap<QString, QStringList> failedBySrc = m_failedModel->relsByGroup();
+    if (failedBySrc.isEmpty()) { QMessageBox::information(this, tr("提示"), tr("没有失败文件需要重试。")); return; }
     if (!isDestOnline()) { QMessageBox::warning(this, tr("设备离线"), tr("目标设备不在线，无法重试。")); return; }
+    m_failedModel->clear(); // 先清空：本次重试再失败的项随后记回
 
     const qint64 speedLimitBps = qint64(m_spinSpeedLimitMB->value()) * 1024 * 1024;
     const int    retentionDays = m_spinRetentionDays->value();
-
-    for (auto it = m_failedBySrc.begin(); it != m_failedBySrc.end(); ++it) {
+    const int    copyLanes     = m_spinCopyLanes->value();
+    const bool   chunkStore    = m_chkChunkStore->isChecked();
+    const bool   delta         = m_chkDelta->isChecked();
+    const bool   verify        = m_chkVerify->isChecked();
+    const auto   hashAlgo      = Digest::Algo(m_comboHashAlgo->currentData().toInt());
+    const int    keepVersions  = m_spinKeepVersions->value();
+    const bool   thin          = m_chkThinVersions->isChecked();
+
+    for (auto it = failedBySrc.cbegin(); it != failedBySrc.cend(); ++it) {
         const QString src = it.key();
         const QStringList rels = it.value();
         const QString dst = m_destEdit->text();
@@ -699,19 +840,31 @@ void MainWindow::onRetryFailed() {
         const int row = addJobRow(src, dst);
         auto *worker = new BackupWorker({
             src, dst,
-            /*verify*/true, /*retries*/3,
+            /*verify*/verify, /*retries*/3,
             /*ignore*/ splitPatterns(m_ignoreEdit->text()),
             /*whitelist*/ rels,
             /*speedLimit*/ speedLimitBps,
             /*keepVersionsOnChange*/ true,
             /*keepDeletedInVault*/   true,
-            /*retentionDays*/        retentionDays
+            /*retentionDays*/        retentionDays,
+            /*chunkStoreVault*/      chunkStore,
+            /*nsName*/               QString(),
+            /*copyLanes*/            copyLanes,
+            /*deltaTransfer*/        delta,
+            /*scopeDirs*/            {},
+            /*scopeTrees*/           {},
+            /*hashAlgo*/             hashAlgo,
+            /*keepVersions*/         keepVersions,
+            /*keepHourly*/           thin ? 24 : 0,
+            /*keepDaily*/            thin ? 30 : 0,
+            /*keepWeekly*/           thin ? 52 : 0
         });
         auto *th = new QThread(this);
         th->setObjectName(QStringLiteral("BackupWorker:Retry:%1").arg(src));
         worker->moveToThread(th);
 
-        Task tk; tk.src=src; tk.dst=dst; tk.worker=worker; tk.thread=th; tk.row=row; tk.paused=false;
+        const std::shared_ptr<BackupProgress> progress = worker->progress();
+        Task tk; tk.src=src; tk.dst=dst; tk.worker=worker; tk.thread=th; tk.row=row; tk.paused=false; tk.progress=progress;
         m_tasks.push_back(tk);
 
         connect(th, &QThread::started, worker, &BackupWorker::run);
@@ -719,35 +872,9 @@ void MainWindow::onRetryFailed() {
         connect(worker, &BackupWorker::deviceOnline,  this, &MainWindow::onWorkerDeviceOnline);
 
         connect(worker, &BackupWorker::stateChanged, this, [=](const QString& s){ m_jobs->item(row,5)->setText(s); });
-        connect(worker, &BackupWorker::progressUpdated, this, [=](qint64 done, qint64 total){
-            auto *bar = qobject_cast<QProgressBar*>(m_jobs->cellWidget(row,2)); if(!bar) return;
-            int pct = total>0 ? int((done*100)/qMax<qint64>(total,1)) : 0;
-            bar->setValue(pct);
-            bar->setFormat(QString("%1%  (%2 / %3 MB)").arg(pct).arg(done/1024/1024).arg(total/1024/1024));
-            m_rowRemainBytes[row] = qMax<qint64>(total - done, 0);
-            updateGlobalStats();
-        });
-        connect(worker, &BackupWorker::speedUpdated, this, [=](double bps){
-            m_jobs->item(row,3)->setText(humanSpeed(bps)); m_rowSpeedBps[row]=bps; updateGlobalStats();
-        });
-        connect(worker, &BackupWorker::etaUpdated, this, [=](qint64 sec){ m_jobs->item(row,4)->setText(humanEta(sec)); });
-        connect(worker, &BackupWorker::fileFinished, this, [=](const QString& rel, bool ok, const QString& err){
-            if (!ok) m_failedList->addItem(src + " :: " + rel + " :: " + err);
-        });
-        connect(worker, &BackupWorker::versionCreated, this, [=](const QString&, const QString& path, const QString& meta){
-            auto *itItem = new QListWidgetItem(QFileInfo(path).fileName());
-            itItem->setToolTip(path);
-            itItem->setData(Qt::UserRole, path);
-            itItem->setData(Qt::UserRole+1, meta);
-            m_versionsList->addItem(itItem);
-        });
-        connect(worker, &BackupWorker::deletedStashed, this, [=](const QString&, const QString& path, const QString& meta){
-            auto *itItem = new QListWidgetItem(QFileInfo(path).fileName());
-            itItem->setToolTip(path);
-            itItem->setData(Qt::UserRole, path);
-            itItem->setData(Qt::UserRole+1, meta);
-            m_deletedList->addItem(itItem);
-        });
+        connectRecordSignals(worker, src); // 再次失败的照常记回失败列表
+        auto reported = std::make_shared<QSet<QString>>();
+        connect(worker, &BackupWorker::fileFailed, this, [reported](const QString& rel, const QString&){ reported->insert(rel); });
 
         // 正确收口
         connect(worker, &BackupWorker::finished, th,     &QThread::quit);
@@ -756,15 +883,19 @@ void MainWindow::onRetryFailed() {
 
         connect(worker, &BackupWorker::finished, this, [=](bool ok, const QString&){
             m_jobs->item(row,5)->setText(ok ? tr("完成") : tr("失败"));
-            m_rowSpeedBps[row]=0.0; updateGlobalStats();
-            for (auto &t : m_tasks) if (t.row==row) { t.worker=nullptr; t.thread=nullptr; }
+            applyProgress(row, *progress); updateGlobalStats();
+            bool cancelled = false;
+            for (auto &t : m_tasks) if (t.row==row) { cancelled = t.cancelled; t.worker=nullptr; t.thread=nullptr; t.progress.reset(); }
+            if (!ok) m_journal.markLost(); // 与备份任务一致：仍有改动没写到目标 → 下次全量
+            // 取消时没轮到的文件留在失败列表（其中已成功的下次重试时索引命中即跳过）
+            if (cancelled)
+                for (const QString& rel : rels)
+                    if (!reported->contains(rel)) m_failedModel->appendFailure(src, rel, tr("重试已取消"));
         });
 
         th->start();
     }
-
-    m_failedBySrc.clear();
-    m_failedList->clear();
+    m_timerProgress->start();
 }
 
 // ========== 自动化 ==========
@@ -788,7 +919,7 @@ void MainWindow::onDeviceCheckTick() {
             // 正在跑且被 UI 暂停过 → 恢复
             if (m_backupRunning) resumeAllTasks(false);
             if (m_chkAutoOnClose->isChecked() && !m_backupRunning && m_pendingChanges)
-                tryStartAutoBackup(tr("设备恢复在线"));
+                tryStartAutoBackup(tr("设备恢复在线"), true);
         } else {
             statusBar()->showMessage(tr("设备离线：暂停自动备份。"), 4000);
             if (m_backupRunning) pauseAllTasks(false);
@@ -800,67 +931,51 @@ void MainWindow::onStabilityTick() {
     const qint64 now = QDateTime::currentMSecsSinceEpoch();
     const qint64 windowMs = qint64(m_spinStabSec->value())*1000;
     if (now - m_lastChangeMs < windowMs) { m_timerStab->start(int(windowMs - (now - m_lastChangeMs))); return; }
-    tryStartAutoBackup(tr("稳定窗口结束"));
+    tryStartAutoBackup(tr("稳定窗口结束"), true);
 }
-void MainWindow::onWatchedPathChanged(const QString& path) {
-    if (!m_chkAutoOnClose->isChecked()) return;
+void MainWindow::onWatchedChanged(const QStringList& dirs, const QStringList& trees) {
+    if (!m_chkAutoOnClose->isChecked()) { m_journal.markLost(); return; }
 
-    // 新增：把新出现的子目录递归加入监听
-    QDir base(path);
-    if (base.exists()) {
-        QDirIterator it(path, QDir::Dirs | QDir::NoDotAndDotDot);
-        while (it.hasNext()) {
-            const QString sub = QDir(it.next()).absolutePath();
-            if (!m_watchedDirs.contains(sub)) {
-                m_watcher->addPath(sub);
-                m_watchedDirs.insert(sub);
-            }
-        }
-    }
+    // 监听器已合并去重；新目录的子目录也已由它加入监听
+    for (const QString& d : dirs)  m_journal.markDir(d);
+    for (const QString& t : trees) m_journal.markTree(t);
 
     m_pendingChanges = true;
     m_lastChangeMs = QDateTime::currentMSecsSinceEpoch();
     m_timerStab->start(m_spinStabSec->value()*1000);
 }
-void MainWindow::tryStartAutoBackup(const QString& reason) {
+void MainWindow::tryStartAutoBackup(const QString& reason, bool incremental) {
     if (m_backupRunning) return;
     if (!isDestOnline()) return;
     onValidate();
     if (!m_btnStart->isEnabled()) return;
     statusBar()->showMessage(tr("自动备份触发：%1").arg(reason), 3000);
     m_pendingChanges = false;
+    m_runFromJournal = incremental;
     onStartBackup();
 }
 
-// ========== 递归监听 ==========
-void MainWindow::rebuildRecursiveWatch(const QString& root) {
-    if (root.isEmpty()) return;
-    QDir base(root);
-    if (!base.exists()) return;
-
-    const QString rootAbs = QDir(root).absolutePath();
-    if (!m_watchedDirs.contains(rootAbs)) {
-        m_watcher->addPath(rootAbs);
-        m_watchedDirs.insert(rootAbs);
-    }
-    QDirIterator it(root, QDir::Dirs|QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
-    while (it.hasNext()) {
-        QString d = QDir(it.next()).absolutePath();
-        if (!m_watchedDirs.contains(d)) {
-            m_watcher->addPath(d);
-            m_watchedDirs.insert(d);
-        }
-    }
+void MainWindow::onWatchOverflow() {
+    // 内核队列/合并缓冲溢出或 watch 数超限：改动已不完整 → 下次全量
+    m_journal.markLost();
+    if (!m_chkAutoOnClose->isChecked()) return;
+    m_pendingChanges = true;
+    m_lastChangeMs = QDateTime::currentMSecsSinceEpoch();
+    m_timerStab->start(m_spinStabSec->value()*1000);
 }
-void MainWindow::refreshWatcher() {
-    for (const auto &d : m_watcher->directories()) m_watcher->removePath(d);
-    for (const auto &f : m_watcher->files())       m_watcher->removePath(f);
-    m_watchedDirs.clear();
 
+// ========== 递归监听 ==========
+void MainWindow::refreshWatcher() {
+    QStringList roots;
     for (int i=0;i<m_sourceList->count();++i) {
         auto *it=m_sourceList->item(i);
-        if (it->checkState()==Qt::Checked) rebuildRecursiveWatch(QDir::cleanPath(it->text()));
+        if (it->checkState()==Qt::Checked) roots << QDir::cleanPath(it->text());
     }
+    // 只增删变化的根目录；新加入的根目录之前没有监听记录 → 下次全量
+    const QStringList before = m_watcher->roots();
+    m_watcher->setRoots(roots);
+    for (const QString& r : m_watcher->roots())
+        if (!before.contains(r)) { m_journal.markLost(); break; }
 }
 
 // ========== 忽略规则 ==========
@@ -904,6 +1019,15 @@ void MainWindow::loadSettings() {
     m_chkSmart->setChecked(s.value("adv/smart/enabled", false).toBool());
     m_spinSmartCpuHi->setValue(s.value("adv/smart/cpu_hi", 65).toInt());
     m_spinSmartPollSec->setValue(s.value("adv/smart/poll_sec", 5).toInt());
+    m_spinCopyLanes->setValue(s.value("adv/copy_lanes", 2).toInt());
+    m_chkChunkStore->setChecked(s.value("adv/chunk_store", false).toBool());
+    m_chkDelta->setChecked(s.value("adv/delta", false).toBool());
+    m_chkVerify->setChecked(s.value("adv/verify", true).toBool());
+    m_spinKeepVersions->setValue(s.value("adv/keep_versions", 0).toInt());
+    m_chkThinVersions->setChecked(s.value("adv/thin_versions", false).toBool());
+    Digest::Algo algo = Digest::Algo::Sha256;
+    Digest::fromName(s.value("adv/hash_algo", "sha256").toString(), &algo);
+    m_comboHashAlgo->setCurrentIndex(qMax(0, m_comboHashAlgo->findData(int(algo)))); // 本版本没有 → SHA-256
 }
 void MainWindow::saveSettings() const {
     QSettings s;
@@ -931,6 +1055,13 @@ void MainWindow::saveSettings() const {
     s.setValue("adv/smart/enabled",  m_chkSmart->isChecked());
     s.setValue("adv/smart/cpu_hi",   m_spinSmartCpuHi->value());
     s.setValue("adv/smart/poll_sec", m_spinSmartPollSec->value());
+    s.setValue("adv/copy_lanes",     m_spinCopyLanes->value());
+    s.setValue("adv/chunk_store",    m_chkChunkStore->isChecked());
+    s.setValue("adv/delta",          m_chkDelta->isChecked());
+    s.setValue("adv/verify",         m_chkVerify->isChecked());
+    s.setValue("adv/keep_versions",  m_spinKeepVersions->value());
+    s.setValue("adv/thin_versions",  m_chkThinVersions->isChecked());
+    s.setValue("adv/hash_algo",      Digest::name(Digest::Algo(m_comboHashAlgo->currentData().toInt())));
 }
 
 // ========== 线程收尾 ==========
@@ -976,30 +1107,88 @@ QString MainWindow::metaRootOfDest() const {
     if (dest.isEmpty()) return {};
     return QDir(dest).absoluteFilePath(".plugbackup_meta");
 }
+void MainWindow::connectRecordSignals(BackupWorker* worker, const QString& src) {
+    connect(worker, &BackupWorker::fileFailed, this, [=](const QString& rel, const QString& err){
+        m_failedModel->appendFailure(src, rel, err);
+    });
+    connect(worker, &BackupWorker::versionCreated, this, [=](const QString& rel, const QString& path, const QString&){
+        addVaultRecord(m_versionsModel, src, rel, path);
+    });
+    connect(worker, &BackupWorker::deletedStashed, this, [=](const QString& rel, const QString& path, const QString&){
+        addVaultRecord(m_deletedModel, src, rel, path);
+    });
+}
+
+// 备份过程中新归档的一项（命名空间取归档路径在 versions/ 或 deleted/ 下的第一层目录）
+void MainWindow::addVaultRecord(RecordListModel* model, const QString& src, const QString& rel, const QString& payload) {
+    const QString ns = QDir(metaRootOfDest()).relativeFilePath(payload).section(QChar('/'), 1, 1);
+    model->appendVault(ns, payload, rel, QDir(src).absolutePath(), QDateTime::currentMSecsSinceEpoch(), /*hasMeta*/ true);
+}
+void MainWindow::refreshVaultNamespaces() {
+    const QString cur = m_vaultNs->currentData().toString();
+    QStringList all = m_versionsModel->groups() + m_deletedModel->groups();
+    if (!cur.isEmpty()) all << cur;          // 重新扫描清空期间保留当前所选
+    all.removeDuplicates();
+    all.sort();
+    QSignalBlocker block(m_vaultNs);        // 只改选项，不触发重新过滤
+    m_vaultNs->clear();
+    m_vaultNs->addItem(tr("全部命名空间"), QString());
+    for (const QString& ns : std::as_const(all)) m_vaultNs->addItem(ns, ns);
+    m_vaultNs->setCurrentIndex(qMax(0, m_vaultNs->findData(cur)));
+}
+void MainWindow::applyVaultFilter() {
+    RecordListModel::Filter f;
+    f.prefix = m_vaultPrefix->text().trimmed();
+    f.group  = m_vaultNs->currentData().toString();
+    const int days = m_vaultAge->currentData().toInt();
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (days > 0) f.fromMs = now - qint64(days) * 86400000;
+    if (days < 0) f.toMs   = now + qint64(days) * 86400000;
+    m_versionsModel->setFilter(f);
+    m_deletedModel->setFilter(f);
+}
 void MainWindow::populateVaultLists() {
-    m_versionsList->clear();
-    m_deletedList->clear();
+    m_versionsModel->clear();
+    m_deletedModel->clear();
     const QString root = metaRootOfDest();
     if (root.isEmpty() || !QDir(root).exists()) return;
 
-    auto scanOne = [&](const QString& subdir, QListWidget* list){
-        const QString base = QDir(root).absoluteFilePath(subdir);
-        QDirIterator it(base, QDir::Files, QDirIterator::Subdirectories);
-        while (it.hasNext()) {
-            it.next();
-            const QString file = it.filePath();
-            if (file.endsWith(".json", Qt::CaseInsensitive)) continue;
-            auto *item = new QListWidgetItem(QFileInfo(file).fileName());
-            item->setToolTip(file);
-            item->setData(Qt::UserRole, file);
-            const QString meta = file + ".json";
-            if (QFileInfo::exists(meta)) item->setData(Qt::UserRole+1, meta);
-            list->addItem(item);
+    // 没有目录的命名空间（旧留存区，下次备份时生成）：遍历并配对 .json；原路径与时间未知（恢复时读 .json）
+    auto scanOne = [&](const QString& ns, const QString& base, RecordListModel* model){
+        QSet<QString> metas;               // 同一遍历里收集 .json，不再逐项 exists()
+        QStringList payloads;
+        TreeWalker::walk(base, {}, [&](TreeWalker::Entry& e){
+            const QString file = base + QChar('/') + e.rel;
+            if (file.endsWith(".json", Qt::CaseInsensitive)) metas.insert(file);
+            else payloads << file;
+            return true;
+        });
+        payloads.sort();                   // 并行遍历无固定顺序
+        for (const QString& file : std::as_const(payloads)) {
+            model->appendVault(ns, file, QString(), QString(), 0, metas.contains(file + ".json"));
         }
     };
 
-    scanOne("versions", m_versionsList);
-    scanOne("deleted",  m_deletedList);
+    // 命名空间 = versions/、deleted/ 下的第一层目录
+    QStringList namespaces;
+    for (const char* sub : {"versions", "deleted"})
+        namespaces << QDir(QDir(root).absoluteFilePath(sub)).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    namespaces.removeDuplicates();
+    namespaces.sort();
+
+    for (const QString& ns : std::as_const(namespaces)) {
+        const VaultCatalog cat(root, ns);
+        if (cat.exists()) {
+            // 顺序读一个文件，不遍历留存区、不解析 .json
+            cat.scan([&](const VaultCatalog::Entry& e){
+                RecordListModel* model = e.kind == VaultCatalog::Kind::Version ? m_versionsModel : m_deletedModel;
+                model->appendVault(ns, e.payload, e.rel, e.srcRoot, e.tsMs, /*hasMeta*/ true);
+            });
+        } else {
+            scanOne(ns, QDir(root).absoluteFilePath("versions/" + ns), m_versionsModel);
+            scanOne(ns, QDir(root).absoluteFilePath("deleted/" + ns),  m_deletedModel);
+        }
+    }
 }
 void MainWindow::onScanVault() {
     populateVaultLists();
@@ -1019,59 +1208,73 @@ static bool readOrigAbsFromMeta(const QString& metaPath, QString* outOrigAbs, QS
     if (outSrcRoot) *outSrcRoot = o.value("srcRoot").toString();
     return true;
 }
+// 列表项带有目录给出的原路径时直接用，否则解析 .json 边车
+static bool readItemOrigin(const QModelIndex& idx, const QString& metaPath, QString* outOrigAbs, QString* outRel) {
+    const QString orig = idx.data(RecordListModel::OrigAbsRole).toString();
+    if (orig.isEmpty()) return readOrigAbsFromMeta(metaPath, outOrigAbs, outRel);
+    *outOrigAbs = orig;
+    *outRel     = idx.data(RecordListModel::RelRole).toString();
+    return true;
+}
 static bool copyFileWithDirs(const QString& from, const QString& to) {
     QDir().mkpath(QFileInfo(to).absolutePath());
     if (QFile::exists(to)) QFile::remove(to);
     return QFile::copy(from, to);
 }
+// 留存项可能是整文件，也可能是分块清单（*.pbm，需按块重组）
+static bool restorePayload(const QString& payload, const QString& metaRoot, const QString& to) {
+    if (ChunkStore::isManifest(payload))
+        return ChunkStore::restoreFile(payload, QDir(metaRoot).absoluteFilePath("chunks"), to);
+    return copyFileWithDirs(payload, to);
+}
 void MainWindow::onRestoreSelectedVersion() {
-    auto *it = m_versionsList->currentItem();
-    if (!it) { QMessageBox::information(this, tr("提示"), tr("请先在“历史版本”中选择一项。")); return; }
+    const QModelIndex it = m_versionsList->currentIndex();
+    if (!it.isValid()) { QMessageBox::information(this, tr("提示"), tr("请先在“历史版本”中选择一项。")); return; }
     const QString payload = itemPayloadPath(it);
     const QString meta    = itemMetaPath(it);
-    if (payload.isEmpty() || meta.isEmpty()) { QMessageBox::warning(this, tr("缺少元数据"), tr("无法定位原始路径。")); return; }
+    if (payload.isEmpty() || (meta.isEmpty() && it.data(RecordListModel::OrigAbsRole).isNull())) { QMessageBox::warning(this, tr("缺少元数据"), tr("无法定位原始路径。")); return; }
 
-    QString origAbs, rel, srcRoot;
-    if (!readOrigAbsFromMeta(meta, &origAbs, &rel, &srcRoot)) {
+    QString origAbs, rel;
+    if (!readItemOrigin(it, meta, &origAbs, &rel)) {
         QMessageBox::warning(this, tr("读取失败"), tr("无法解析元数据：%1").arg(meta));
         return;
     }
     if (QMessageBox::question(this, tr("恢复历史版本"),
                               tr("将把历史版本恢复到源文件位置：\n%1\n\n继续？").arg(origAbs)) != QMessageBox::Yes) return;
 
-    if (!copyFileWithDirs(payload, origAbs)) {
+    if (!restorePayload(payload, metaRootOfDest(), origAbs)) {
         QMessageBox::warning(this, tr("恢复失败"), tr("拷贝失败：%1 → %2").arg(payload, origAbs));
         return;
     }
     statusBar()->showMessage(tr("已恢复历史版本 → %1").arg(origAbs), 3000);
 }
 void MainWindow::onRestoreSelectedDeleted() {
-    auto *it = m_deletedList->currentItem();
-    if (!it) { QMessageBox::information(this, tr("提示"), tr("请先在“删除留存”中选择一项。")); return; }
+    const QModelIndex it = m_deletedList->currentIndex();
+    if (!it.isValid()) { QMessageBox::information(this, tr("提示"), tr("请先在“删除留存”中选择一项。")); return; }
     const QString payload = itemPayloadPath(it);
     const QString meta    = itemMetaPath(it);
-    if (payload.isEmpty() || meta.isEmpty()) { QMessageBox::warning(this, tr("缺少元数据"), tr("无法定位原始路径。")); return; }
+    if (payload.isEmpty() || (meta.isEmpty() && it.data(RecordListModel::OrigAbsRole).isNull())) { QMessageBox::warning(this, tr("缺少元数据"), tr("无法定位原始路径。")); return; }
 
-    QString origAbs, rel, srcRoot;
-    if (!readOrigAbsFromMeta(meta, &origAbs, &rel, &srcRoot)) {
+    QString origAbs, rel;
+    if (!readItemOrigin(it, meta, &origAbs, &rel)) {
         QMessageBox::warning(this, tr("读取失败"), tr("无法解析元数据：%1").arg(meta));
         return;
     }
     if (QMessageBox::question(this, tr("恢复删除留存"),
                               tr("将把删除留存恢复到源文件位置：\n%1\n\n继续？").arg(origAbs)) != QMessageBox::Yes) return;
 
-    if (!copyFileWithDirs(payload, origAbs)) {
+    if (!restorePayload(payload, metaRootOfDest(), origAbs)) {
         QMessageBox::warning(this, tr("恢复失败"), tr("拷贝失败：%1 → %2").arg(payload, origAbs));
         return;
     }
     const QString dstPath = QDir(QDir::cleanPath(m_destEdit->text())).absoluteFilePath(rel);
-    copyFileWithDirs(payload, dstPath);
+    restorePayload(payload, metaRootOfDest(), dstPath);
 
     statusBar()->showMessage(tr("已恢复删除留存 → %1").arg(origAbs), 3000);
 }
 
-QString MainWindow::itemPayloadPath(QListWidgetItem* it) { return it ? it->data(Qt::UserRole).toString() : QString(); }
-QString MainWindow::itemMetaPath(QListWidgetItem* it)    { return it ? it->data(Qt::UserRole+1).toString() : QString(); }
+QString MainWindow::itemPayloadPath(const QModelIndex& idx) { return idx.data(RecordListModel::PayloadRole).toString(); }
+QString MainWindow::itemMetaPath(const QModelIndex& idx)    { return idx.data(RecordListModel::MetaRole).toString(); }
 
 // ========== 智能模式 ==========
 void MainWindow::pauseAllTasks(bool fromSmart) {
@@ -1290,7 +1493,7 @@ void MainWindow::applyTheme() {
     }
 
     /* 列表/多行文本 */
-    QListWidget, QTextEdit {
+    QListView, QTextEdit {
         background:#ffffff;
         border:1px solid #e5e7eb;
         border-radius:10px;
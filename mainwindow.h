@@ -5,8 +5,13 @@
 #include <QMap>
 #include <QCloseEvent>
 #include <QPointer>
+#include <memory>
+
+#include "DirtyJournal.h"
 
 class QListWidget;
+class QListView;
+class QModelIndex;
 class QLineEdit;
 class QPushButton;
 class QLabel;
@@ -14,11 +19,14 @@ class QListWidgetItem;
 class QTableWidget;
 class QCheckBox;
 class QSpinBox;
-class QFileSystemWatcher;
+class QComboBox;
+class RecursiveWatcher;
 class QTimer;
 class QToolButton;
 
 class BackupWorker;
+class BackupProgress;
+class RecordListModel;
 
 /**
  * @brief 主窗口：源/目标选择 + 自动化策略 + 任务表（暂停/继续/取消）
@@ -48,13 +56,15 @@ private slots:
     void onResumeRow();
     void onCancelRow();
     void onRetryFailed();
+    void onProgressTick();       // 定时读取各任务的进度快照
 
     // —— 自动化 —— //
     void onAutoOptionsChanged();
     void onDeviceCheckTick();
     void onAutoIntervalTick();
     void onStabilityTick();
-    void onWatchedPathChanged(const QString& path);
+    void onWatchedChanged(const QStringList& dirs, const QStringList& trees);
+    void onWatchOverflow();
     void onWorkerDeviceOffline(const QString& phase);
     void onWorkerDeviceOnline();
 
@@ -73,12 +83,11 @@ private:
     bool anySourceInsideAnother(QString *a=nullptr, QString *b=nullptr) const;
     bool isDestOnline() const;
 
-    // 监听（递归）
+    // 监听（递归）：按勾选的源目录增删根目录
     void refreshWatcher();
-    void rebuildRecursiveWatch(const QString& root);
 
     // 自动触发备份
-    void tryStartAutoBackup(const QString& reason);
+    void tryStartAutoBackup(const QString& reason, bool incremental = false); // incremental：按监听日志只扫改动的目录
 
     // 忽略规则解析
     QStringList splitPatterns(const QString& text) const;
@@ -91,6 +100,7 @@ private:
     int  addJobRow(const QString& src, const QString& dst);
     void addOpButtons(int row);
     void updateGlobalStats();
+    void applyProgress(int row, const BackupProgress& progress);
     QSet<const void*> m_offlineWorkers; // 正处于离线等待的 worker 集合（用指针去重）
     QPointer<class QMessageBox> m_offlineBox; // 非模态提示框
 
@@ -100,8 +110,12 @@ private:
     // 版本/回收站 面板工具
     QString metaRootOfDest() const;
     void populateVaultLists();
-    static QString itemPayloadPath(QListWidgetItem* it);
-    static QString itemMetaPath(QListWidgetItem* it);
+    void addVaultRecord(RecordListModel* model, const QString& src, const QString& rel, const QString& payload);
+    void connectRecordSignals(BackupWorker* worker, const QString& src); // 失败项/版本/删除留存 → 各列表（备份与重试共用）
+    void refreshVaultNamespaces();
+    void applyVaultFilter();
+    static QString itemPayloadPath(const QModelIndex& idx);
+    static QString itemMetaPath(const QModelIndex& idx);
 
     // 智能模式：批量暂停/恢复
     void pauseAllTasks(bool fromSmart);
@@ -130,12 +144,18 @@ private:
     QVector<qint64> m_rowRemainBytes;
 
     // ======= UI：失败重试 ======= //
-    QListWidget* m_failedList  = nullptr;
-    QPushButton* m_btnRetryFailed = nullptr;
+    QListView*       m_failedList  = nullptr;
+    RecordListModel* m_failedModel = nullptr;   // 失败文件：按源目录分组，重试时取出
+    QPushButton*     m_btnRetryFailed = nullptr;
 
     // ======= UI：版本与删除留存 ======= //
-    QListWidget* m_versionsList = nullptr;
-    QListWidget* m_deletedList  = nullptr;
+    QListView*       m_versionsList  = nullptr;
+    QListView*       m_deletedList   = nullptr;
+    RecordListModel* m_versionsModel = nullptr;
+    RecordListModel* m_deletedModel  = nullptr;
+    QLineEdit*       m_vaultPrefix   = nullptr; // 筛选：相对路径前缀
+    QComboBox*       m_vaultNs       = nullptr; // 筛选：命名空间
+    QComboBox*       m_vaultAge      = nullptr; // 筛选：时间范围（天数存在 userData，负数 = 早于）
     QPushButton* m_btnScanVault = nullptr;
     QPushButton* m_btnRestoreVersion = nullptr;
     QPushButton* m_btnRestoreDeleted = nullptr;
@@ -153,18 +173,27 @@ private:
     QCheckBox* m_chkSmart          = nullptr; // 智能模式：繁忙时暂停
     QSpinBox*  m_spinSmartCpuHi    = nullptr; // 繁忙阈值（%）
     QSpinBox*  m_spinSmartPollSec  = nullptr; // 轮询间隔（秒）
+    QSpinBox*  m_spinCopyLanes     = nullptr; // 并行复制通道数
+    QCheckBox* m_chkChunkStore     = nullptr; // 版本/删除留存使用分块去重存储
+    QCheckBox* m_chkDelta          = nullptr; // 大文件增量复制
+    QCheckBox* m_chkVerify         = nullptr; // 复制后校验
+    QComboBox* m_comboHashAlgo     = nullptr; // 摘要算法（Digest::Algo 存在 userData）
+    QSpinBox*  m_spinKeepVersions  = nullptr; // 每个文件最多保留版本数（0=不限）
+    QCheckBox* m_chkThinVersions   = nullptr; // 按小时/天/周稀疏旧版本
 
     // ======= 监控与定时 ======= //
-    QFileSystemWatcher* m_watcher = nullptr;
+    RecursiveWatcher* m_watcher = nullptr;
     QTimer* m_timerDevice  = nullptr;
     QTimer* m_timerInterval= nullptr;
     QTimer* m_timerStab    = nullptr;
     QTimer* m_timerSmart   = nullptr;   // 智能模式轮询
+    QTimer* m_timerProgress= nullptr;   // 任务进度快照（运行中才开）
 
     bool   m_deviceOnline   = false;
     bool   m_backupRunning  = false;
     bool   m_pendingChanges = false;
     qint64 m_lastChangeMs   = 0;
+    QSet<QString> m_massDeletionOk;     // 已确认确实大量删除的源：下一轮照常移入删除留存（用一次即清）
 
     // 智能模式状态
     bool   m_smartPaused    = false;
@@ -176,8 +205,9 @@ private:
     quint64 m_prevKernel    = 0;
     quint64 m_prevUser      = 0;
 
-    // 已递归添加的目录集合（绝对路径）
-    QSet<QString> m_watchedDirs;
+    // 监听到的脏目录：自动触发时据此只扫描改动部分
+    DirtyJournal m_journal;
+    bool         m_runFromJournal = false; // 下一次 onStartBackup 来自监听触发
 
     // 行 → 任务对象
     struct Task {
@@ -187,9 +217,8 @@ private:
         QThread*      thread = nullptr;
         int           row    = -1;
         bool          paused = false;
+        bool          cancelled = false;           // 用户点了取消（重试任务据此把没轮到的文件留在失败列表）
+        std::shared_ptr<BackupProgress> progress; // 运行中非空
     };
     QVector<Task> m_tasks;
-
-    // 失败文件：key=srcDir，value=相对路径列表
-    QMap<QString, QStringList> m_failedBySrc;
 };
@@ -0,0 +1,186 @@
+#include "recordlistmodel.h"
+
+#include <QDateTime>
+#include <QTimer>
+
+#include <cstring>
+
+RecordListModel::RecordListModel(Kind kind, QObject* parent)
+    : QAbstractListModel(parent), m_kind(kind) {
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(kFlushMs);
+    connect(m_flushTimer, &QTimer::timeout, this, &RecordListModel::flush);
+}
+
+quint32 RecordListModel::intern(QStringList& list, QHash<QString, quint32>& ids, const QString& s, bool* added) {
+    auto it = ids.constFind(s);
+    if (it != ids.constEnd()) return it.value();
+    const quint32 id = quint32(list.size());
+    list << s;
+    ids.insert(s, id);
+    if (added) *added = true;
+    return id;
+}
+
+void RecordListModel::appendVault(const QString& ns, const QString& payload, const QString& rel,
+                                  const QString& srcRoot, qint64 tsMs, bool hasMeta) {
+    bool newGroup = false;
+    Row r;
+    r.group   = intern(m_groups, m_groupIds, ns, &newGroup);
+    r.root    = srcRoot.isEmpty() ? kNone : intern(m_roots, m_rootIds, srcRoot);
+    r.hasMeta = hasMeta;
+    r.tsMs    = tsMs;
+
+    const QByteArray u8Rel = rel.toUtf8(), u8Payload = payload.toUtf8();
+    r.off      = quint32(m_arena.size());
+    r.relLen   = quint32(u8Rel.size());
+    r.extraLen = quint32(u8Payload.size());
+    m_arena.insert(m_arena.end(), u8Rel.constData(), u8Rel.constData() + u8Rel.size());
+    m_arena.insert(m_arena.end(), u8Payload.constData(), u8Payload.constData() + u8Payload.size());
+
+    if (newGroup && ns == m_filter.group) m_filterGroup = r.group;
+    push(r);
+    if (newGroup) emit groupsChanged();
+}
+
+void RecordListModel::appendFailure(const QString& src, const QString& rel, const QString& err) {
+    bool newGroup = false;
+    Row r;
+    r.group   = intern(m_groups, m_groupIds, src, &newGroup);
+    r.root    = kNone;
+    r.hasMeta = false;
+    r.tsMs    = QDateTime::currentMSecsSinceEpoch();
+
+    const QByteArray u8Rel = rel.toUtf8(), u8Err = err.toUtf8();
+    r.off      = quint32(m_arena.size());
+    r.relLen   = quint32(u8Rel.size());
+    r.extraLen = quint32(u8Err.size());
+    m_arena.insert(m_arena.end(), u8Rel.constData(), u8Rel.constData() + u8Rel.size());
+    m_arena.insert(m_arena.end(), u8Err.constData(), u8Err.constData() + u8Err.size());
+
+    if (newGroup && src == m_filter.group) m_filterGroup = r.group;
+    push(r);
+    if (newGroup) emit groupsChanged();
+}
+
+void RecordListModel::clear() {
+    m_flushTimer->stop();
+    beginResetModel();
+    m_rows.clear();
+    m_arena.clear();
+    m_match.clear();
+    m_groups.clear(); m_groupIds.clear();
+    m_roots.clear();  m_rootIds.clear();
+    m_filterGroup = kNone;
+    m_fetched  = 0;
+    m_caughtUp = true;
+    endResetModel();
+    emit groupsChanged();
+}
+
+void RecordListModel::push(const Row& r) {
+    m_rows.push_back(r);
+    if (!m_filter.isEmpty() && matches(r)) m_match.push_back(quint32(m_rows.size() - 1));
+    scheduleFlush();
+}
+
+void RecordListModel::scheduleFlush() {
+    if (!m_flushTimer->isActive()) m_flushTimer->start();
+}
+
+// 一帧内追加的行合成一次插入；视图已拿到此前全部行时跟进一批，否则留给 fetchMore
+void RecordListModel::flush() {
+    if (m_caughtUp) exposeMore();
+}
+
+void RecordListModel::exposeMore() {
+    const int avail = visibleCount();
+    if (m_fetched >= avail) return;
+    const int to = qMin(avail, m_fetched + kFetchBatch);
+    beginInsertRows(QModelIndex(), m_fetched, to - 1);
+    m_fetched = to;
+    endInsertRows();
+    m_caughtUp = m_fetched == avail;
+}
+
+bool RecordListModel::matches(const Row& r) const {
+    if (!m_filter.group.isEmpty() && r.group != m_filterGroup) return false;
+    if (m_filter.fromMs > 0 && r.tsMs < m_filter.fromMs) return false;
+    if (m_filter.toMs   > 0 && r.tsMs > m_filter.toMs)   return false;
+    if (!m_prefixUtf8.isEmpty()) {
+        const quint32 n = quint32(m_prefixUtf8.size());
+        if (r.relLen < n || memcmp(m_arena.data() + r.off, m_prefixUtf8.constData(), n) != 0) return false;
+    }
+    return true;
+}
+
+void RecordListModel::setFilter(const Filter& f) {
+    m_flushTimer->stop();
+    beginResetModel();
+    m_filter      = f;
+    m_prefixUtf8  = f.prefix.toUtf8();
+    m_filterGroup = m_groupIds.value(f.group, kNone);
+    m_match.clear();
+    if (!m_filter.isEmpty()) {
+        for (size_t i = 0; i < m_rows.size(); ++i)
+            if (matches(m_rows[i])) m_match.push_back(quint32(i));
+    }
+    m_fetched  = qMin(visibleCount(), kFetchBatch);
+    m_caughtUp = m_fetched == visibleCount();
+    endResetModel();
+}
+
+QMap<QString, QStringList> RecordListModel::relsByGroup() const {
+    QMap<QString, QStringList> out;
+    for (const Row& r : m_rows) out[m_groups[int(r.group)]] << text(r.off, r.relLen);
+    return out;
+}
+
+int RecordListModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : m_fetched;
+}
+
+bool RecordListModel::canFetchMore(const QModelIndex& parent) const {
+    return !parent.isValid() && m_fetched < visibleCount();
+}
+
+void RecordListModel::fetchMore(const QModelIndex& parent) {
+    if (!parent.isValid()) exposeMore();
+}
+
+QVariant RecordListModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_fetched) return {};
+    const Row& r = visibleRow(index.row());
+    const quint32 extraOff = r.off + r.relLen;
+
+    if (m_kind == Kind::Failure) {
+        switch (role) {
+        case Qt::DisplayRole:
+        case Qt::ToolTipRole:
+            return m_groups[int(r.group)] + " :: " + text(r.off, r.relLen) + " :: " + text(extraOff, r.extraLen);
+        case RelRole:   return text(r.off, r.relLen);
+        case GroupRole: return m_groups[int(r.group)];
+        case TimeRole:  return r.tsMs;
+        default:        return {};
+        }
+    }
+
+    switch (role) {
+    case Qt::DisplayRole: {
+        // 归档文件名：payload 最后一个 '/' 之后
+        const char* p = m_arena.data() + extraOff;
+        quint32 name = r.extraLen;
+        while (name > 0 && p[name - 1] != '/') --name;
+        return text(extraOff + name, r.extraLen - name);
+    }
+    case Qt::ToolTipRole:
+    case PayloadRole: return text(extraOff, r.extraLen);
+    case MetaRole:    return r.hasMeta ? QVariant(text(extraOff, r.extraLen) + ".json") : QVariant();
+    case OrigAbsRole: return r.root == kNone ? QVariant() : QVariant(m_roots[int(r.root)] + QChar('/') + text(r.off, r.relLen));
+    case RelRole:     return text(r.off, r.relLen);
+    case GroupRole:   return m_groups[int(r.group)];
+    case TimeRole:    return r.tsMs;
+    default:          return {};
+    }
+}
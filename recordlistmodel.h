@@ -0,0 +1,109 @@
+#pragma once
+#include <QAbstractListModel>
+#include <QByteArray>
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+class QTimer;
+
+/**
+ * @brief 留存区（历史版本/删除留存）与失败文件列表的模型，配 QListView 使用，替代逐项 QListWidgetItem
+ * - 紧凑存储：每行一个定长 Row，路径/错误文本以 UTF-8 连续存进 arena；命名空间、源根等重复串只存一份。
+ *   显示文字与恢复所需的路径都在 data() 里按需拼出，不为每行保留 QString/QVariant
+ * - 按需取行：rowCount() 只报告已放出的行，视图滚到底时 fetchMore() 每次再放出 kFetchBatch 行
+ * - 按帧合并：append*() 只写存储，kFlushMs 后一次 beginInsertRows/endInsertRows（同一帧内的信号合成一次插入）
+ * - 过滤（路径前缀/命名空间/时间）直接比较存储里的字段，只保留匹配行的下标
+ * 只在 GUI 线程使用。
+ */
+class RecordListModel : public QAbstractListModel {
+    Q_OBJECT
+public:
+    enum class Kind { Vault, Failure };
+
+    // 与旧列表项的数据位一致：UserRole=归档文件，+1=.json，+2=原路径（已知时），+3=相对路径
+    enum Role {
+        PayloadRole = Qt::UserRole,
+        MetaRole,
+        OrigAbsRole,
+        RelRole,
+        GroupRole,                                          // 命名空间（留存项）/ 源目录（失败项）
+        TimeRole                                            // 归档/失败时间（UTC 毫秒）
+    };
+
+    static constexpr int kFetchBatch = 1000;
+    static constexpr int kFlushMs    = 16;
+
+    struct Filter {
+        QString prefix;                                     // 相对路径前缀（空 = 不限）
+        QString group;                                      // 命名空间/源目录（空 = 不限）
+        qint64  fromMs = 0;                                 // 时间下限（0 = 不限）
+        qint64  toMs   = 0;                                 // 时间上限（0 = 不限）
+
+        bool isEmpty() const { return prefix.isEmpty() && group.isEmpty() && fromMs == 0 && toMs == 0; }
+    };
+
+    explicit RecordListModel(Kind kind, QObject* parent = nullptr);
+
+    // 留存项；srcRoot 为空表示原路径未知（恢复时读 .json 边车）
+    void appendVault(const QString& ns, const QString& payload, const QString& rel,
+                     const QString& srcRoot, qint64 tsMs, bool hasMeta);
+    // 失败项；时间取当前
+    void appendFailure(const QString& src, const QString& rel, const QString& err);
+    void clear();
+
+    void setFilter(const Filter& f);
+    const Filter& filter() const { return m_filter; }
+
+    int totalCount() const { return int(m_rows.size()); }  // 不计过滤
+    QStringList groups() const { return m_groups; }         // 出现过的命名空间/源目录（按出现顺序）
+    QMap<QString, QStringList> relsByGroup() const;         // 失败重试：源目录 → 相对路径
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+signals:
+    void groupsChanged();
+
+private:
+    static constexpr quint32 kNone = 0xffffffffu;
+
+    struct Row {
+        quint32 group;                                      // m_groups 下标
+        quint32 root;                                       // m_roots 下标（kNone = 未知）
+        quint32 off;                                        // arena 偏移：rel 紧接着 payload（失败项为错误文本）
+        quint32 relLen;
+        quint32 extraLen;
+        bool    hasMeta;
+        qint64  tsMs;
+    };
+
+    quint32 intern(QStringList& list, QHash<QString, quint32>& ids, const QString& s, bool* added = nullptr);
+    void push(const Row& r);
+    void scheduleFlush();
+    void flush();
+    void exposeMore();                                      // 再放出至多 kFetchBatch 行
+    bool matches(const Row& r) const;
+    int  visibleCount() const { return m_filter.isEmpty() ? int(m_rows.size()) : int(m_match.size()); }
+    const Row& visibleRow(int row) const { return m_rows[m_filter.isEmpty() ? size_t(row) : m_match[size_t(row)]]; }
+    QString text(quint32 off, quint32 len) const { return QString::fromUtf8(m_arena.data() + off, int(len)); }
+
+    Kind m_kind;
+    std::vector<Row>     m_rows;
+    std::vector<char>    m_arena;
+    std::vector<quint32> m_match;                           // 过滤生效时：匹配行在 m_rows 中的下标
+    QStringList             m_groups, m_roots;
+    QHash<QString, quint32> m_groupIds, m_rootIds;
+
+    Filter     m_filter;
+    QByteArray m_prefixUtf8;
+    quint32    m_filterGroup = kNone;                       // m_filter.group 的下标（尚未出现为 kNone）
+
+    int     m_fetched = 0;                                  // 已放给视图的行数（≤ visibleCount()）
+    bool    m_caughtUp = true;                              // 上次放行后视图已拿到全部行：新行可直接跟进
+    QTimer* m_flushTimer = nullptr;
+};
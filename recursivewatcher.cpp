@@ -0,0 +1,461 @@
+#include "recursivewatcher.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSocketNotifier>
+#include <QTimer>
+
+#include <utility>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <climits>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <unistd.h>
+#include <sys/fanotify.h>
+#if defined(FAN_REPORT_DFID_NAME)
+#define PLUGBACKUP_HAVE_FANOTIFY 1
+#endif
+#endif
+
+static const int kRingCapacity = 8192;  // 一个合并窗口内最多记录的不同目录；再多就该全量了
+static const int kFlushBatch   = 1024;  // 每次 changed 最多携带的条目
+static const int kFlushDelayMs = 100;   // 合并窗口
+
+static QString cleanAbs(const QString& p) { return QDir::cleanPath(QDir(p).absolutePath()); }
+static QString ringKey(const QString& path, bool tree) { return QString(QChar(tree ? 't' : 'd')) + path; }
+
+RecursiveWatcher::RecursiveWatcher(QObject* parent) : QObject(parent) {
+    m_ring.resize(kRingCapacity);
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(kFlushDelayMs);
+    connect(m_flushTimer, &QTimer::timeout, this, &RecursiveWatcher::flush);
+
+#ifdef PLUGBACKUP_HAVE_FANOTIFY
+    // 新内核上非特权进程也能 init，但文件系统级标记会 EPERM，届时按根目录退到 inotify
+    m_fanFd = ::fanotify_init(FAN_CLASS_NOTIF | FAN_CLOEXEC | FAN_NONBLOCK | FAN_REPORT_DFID_NAME,
+                              O_RDONLY | O_LARGEFILE);
+    if (m_fanFd >= 0) {
+        m_fanNotifier = new QSocketNotifier(m_fanFd, QSocketNotifier::Read, this);
+        connect(m_fanNotifier, &QSocketNotifier::activated, this, [this]{ readFanotify(); });
+    }
+#endif
+}
+
+RecursiveWatcher::~RecursiveWatcher() {
+    // 先停通知器再关 fd
+    delete m_fanNotifier;
+    delete m_inoNotifier;
+#ifdef Q_OS_LINUX
+    for (const FsMark& m : std::as_const(m_fsMarks)) ::close(m.mountFd);
+    if (m_fanFd >= 0) ::close(m_fanFd);
+    if (m_inoFd >= 0) ::close(m_inoFd);
+#endif
+}
+
+// ========== 根目录管理 ==========
+void RecursiveWatcher::addRoot(const QString& path) {
+    const QString root = cleanAbs(path);
+    if (path.isEmpty() || m_roots.contains(root) || !QFileInfo(root).isDir()) return;
+    const QString canon = QFileInfo(root).canonicalFilePath();
+    m_rootCanon.insert(root, canon.isEmpty() ? root : canon);
+    if (addFanotifyRoot(root)) { m_roots.insert(root, Backend::Fanotify); return; }
+    if (addInotifyRoot(root))  { m_roots.insert(root, Backend::Inotify);  return; }
+    addPollingRoot(root);
+    m_roots.insert(root, Backend::Polling);
+}
+
+void RecursiveWatcher::removeRoot(const QString& path) {
+    const QString root = cleanAbs(path);
+    auto it = m_roots.find(root);
+    if (it == m_roots.end()) return;
+    switch (*it) {
+    case Backend::Fanotify: removeFanotifyRoot(root); break;
+    case Backend::Inotify:  removeInotifyRoot(root);  break;
+    case Backend::Polling:  removePollingRoot(root);  break;
+    }
+    m_roots.erase(it);
+    m_rootCanon.remove(root);
+}
+
+void RecursiveWatcher::setRoots(const QStringList& paths) {
+    QSet<QString> want;
+    for (const QString& p : paths) if (!p.isEmpty()) want.insert(cleanAbs(p));
+    for (const QString& r : m_roots.keys()) if (!want.contains(r)) removeRoot(r);
+    for (const QString& r : std::as_const(want)) addRoot(r);
+}
+
+RecursiveWatcher::Backend RecursiveWatcher::backendFor(const QString& root) const {
+    return m_roots.value(cleanAbs(root), Backend::Polling);
+}
+
+int RecursiveWatcher::watchCount() const {
+    return int(m_fsMarks.size() + m_nodes.size() + m_polledDirs.size());
+}
+
+QString RecursiveWatcher::toRootPath(const QString& canonical) const {
+    for (auto it = m_rootCanon.cbegin(); it != m_rootCanon.cend(); ++it) {
+        const QString& c = it.value();
+        if (canonical == c) return it.key();
+        if (canonical.startsWith(c) && canonical.size() > c.size() && canonical.at(c.size()) == QChar('/'))
+            return it.key() + canonical.mid(c.size());
+    }
+    return QString();
+}
+
+// ========== 合并缓冲 ==========
+void RecursiveWatcher::enqueue(const QString& path, bool tree) {
+    const QString key = ringKey(path, tree);
+    if (m_ringKeys.contains(key)) return;
+    if (m_ringSize == m_ring.size()) { markOverflow(); return; }
+    m_ring[(m_ringHead + m_ringSize) % m_ring.size()] = Pending{path, tree};
+    ++m_ringSize;
+    m_ringKeys.insert(key);
+    if (!m_flushTimer->isActive()) m_flushTimer->start();
+}
+
+void RecursiveWatcher::markOverflow() {
+    m_overflow = true;
+    if (!m_flushTimer->isActive()) m_flushTimer->start();
+}
+
+void RecursiveWatcher::flush() {
+    // 超出 watch 上限时有目录没被监听，之后的每一批都不完整
+    const bool lost = m_overflow || m_watchLimitHit;
+    m_overflow = false;
+
+    QStringList dirs, trees;
+    const int n = qMin(m_ringSize, kFlushBatch);
+    for (int i = 0; i < n; ++i) {
+        Pending& p = m_ring[m_ringHead];
+        m_ringKeys.remove(ringKey(p.path, p.tree));
+        (p.tree ? trees : dirs) << std::exchange(p.path, QString());
+        m_ringHead = (m_ringHead + 1) % m_ring.size();
+    }
+    m_ringSize -= n;
+    if (m_ringSize > 0) m_flushTimer->start();
+
+    if (lost) emit overflowed();
+    if (!dirs.isEmpty() || !trees.isEmpty()) emit changed(dirs, trees);
+}
+
+// ========== Polling（QFileSystemWatcher） ==========
+void RecursiveWatcher::addPollingRoot(const QString& root) {
+    if (!m_poller) {
+        m_poller = new QFileSystemWatcher(this);
+        connect(m_poller, &QFileSystemWatcher::directoryChanged, this, &RecursiveWatcher::onPolledDirChanged);
+    }
+    QStringList dirs{root};
+    QDirIterator it(root, QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks, QDirIterator::Subdirectories);
+    while (it.hasNext()) dirs << cleanAbs(it.next());
+    for (const QString& d : std::as_const(dirs)) m_polledDirs.insert(d);
+    m_poller->addPaths(dirs); // 一次批量添加，避免逐个 addPath 的重复开销
+}
+
+void RecursiveWatcher::removePollingRoot(const QString& root) {
+    QStringList gone;
+    const QString prefix = root + QChar('/');
+    for (const QString& d : std::as_const(m_polledDirs))
+        if (d == root || d.startsWith(prefix)) gone << d;
+    for (const QString& d : std::as_const(gone)) m_polledDirs.remove(d);
+    if (m_poller && !gone.isEmpty()) m_poller->removePaths(gone);
+}
+
+void RecursiveWatcher::onPolledDirChanged(const QString& path) {
+    const QString dir = cleanAbs(path);
+    if (!QFileInfo(dir).isDir()) {
+        // 目录被删/改名走：QFileSystemWatcher 已自动移除；父目录重扫时处理
+        m_polledDirs.remove(dir);
+        enqueue(dir, false);
+        enqueue(QFileInfo(dir).absolutePath(), false);
+        return;
+    }
+    QStringList fresh;
+    QDirIterator it(dir, QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+    while (it.hasNext()) {
+        const QString sub = cleanAbs(it.next());
+        if (m_polledDirs.contains(sub)) continue;
+        // 新目录：整棵加入监听；注册前可能已写入文件 → 整棵记为改动
+        fresh << sub;
+        QDirIterator deep(sub, QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks, QDirIterator::Subdirectories);
+        while (deep.hasNext()) fresh << cleanAbs(deep.next());
+        enqueue(sub, true);
+    }
+    for (const QString& d : std::as_const(fresh)) m_polledDirs.insert(d);
+    if (!fresh.isEmpty()) m_poller->addPaths(fresh);
+    enqueue(dir, false);
+}
+
+#ifdef Q_OS_LINUX
+// ========== Fanotify ==========
+#ifdef PLUGBACKUP_HAVE_FANOTIFY
+static const quint64 kFanMask = FAN_CREATE | FAN_DELETE | FAN_MOVED_FROM | FAN_MOVED_TO
+                              | FAN_MODIFY | FAN_ATTRIB | FAN_ONDIR;
+
+// 目录句柄 → 当前路径（规范路径；需要 CAP_DAC_READ_SEARCH；目录已删除时返回空）
+static QString resolveDirHandle(int mountFd, const file_handle* fh) {
+    QByteArray h(reinterpret_cast<const char*>(fh), qsizetype(sizeof(file_handle) + fh->handle_bytes));
+    const int fd = ::open_by_handle_at(mountFd, reinterpret_cast<file_handle*>(h.data()), O_PATH | O_CLOEXEC);
+    if (fd < 0) return QString();
+    char buf[PATH_MAX];
+    const QByteArray link = QByteArray("/proc/self/fd/").append(QByteArray::number(fd));
+    const ssize_t n = ::readlink(link.constData(), buf, sizeof(buf) - 1);
+    ::close(fd);
+    if (n <= 0) return QString();
+    const QByteArray path(buf, qsizetype(n));
+    if (path.endsWith(" (deleted)")) return QString();
+    return QFile::decodeName(path);
+}
+#endif
+
+bool RecursiveWatcher::addFanotifyRoot(const QString& root) {
+#ifdef PLUGBACKUP_HAVE_FANOTIFY
+    if (m_fanFd < 0) return false;
+    const QByteArray native = QFile::encodeName(root);
+    struct statfs sfs;
+    if (::statfs(native.constData(), &sfs) != 0) return false;
+    const QByteArray fsid(reinterpret_cast<const char*>(&sfs.f_fsid), qsizetype(sizeof(sfs.f_fsid)));
+
+    auto it = m_fsMarks.find(fsid);
+    if (it == m_fsMarks.end()) {
+        const int mountFd = ::open(native.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (mountFd < 0) return false;
+        // EPERM：没有 CAP_SYS_ADMIN；ENODEV/EXDEV/EOPNOTSUPP：文件系统不支持文件句柄（FAT/FUSE 等）
+        if (::fanotify_mark(m_fanFd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, kFanMask, mountFd, nullptr) != 0) {
+            ::close(mountFd);
+            return false;
+        }
+        FsMark mark;
+        mark.mountFd = mountFd;
+        it = m_fsMarks.insert(fsid, mark);
+    }
+    ++it->refs;
+    m_rootFsid.insert(root, fsid);
+    return true;
+#else
+    Q_UNUSED(root);
+    return false;
+#endif
+}
+
+void RecursiveWatcher::removeFanotifyRoot(const QString& root) {
+#ifdef PLUGBACKUP_HAVE_FANOTIFY
+    const QByteArray fsid = m_rootFsid.take(root);
+    auto it = m_fsMarks.find(fsid);
+    if (it == m_fsMarks.end() || --it->refs > 0) return;
+    ::fanotify_mark(m_fanFd, FAN_MARK_REMOVE | FAN_MARK_FILESYSTEM, kFanMask, it->mountFd, nullptr);
+    ::close(it->mountFd);
+    m_fsMarks.erase(it);
+#else
+    Q_UNUSED(root);
+#endif
+}
+
+void RecursiveWatcher::readFanotify() {
+#ifdef PLUGBACKUP_HAVE_FANOTIFY
+    alignas(fanotify_event_metadata) char buf[64 * 1024];
+    for (;;) {
+        const ssize_t n = ::read(m_fanFd, buf, sizeof(buf));
+        if (n <= 0) break; // EAGAIN：已读空
+
+        // 文件系统级标记会收到整个文件系统的事件：同一批里同一目录只解析一次路径
+        QHash<QByteArray, QString> resolved;
+        ssize_t len = n;
+        for (auto* meta = reinterpret_cast<const fanotify_event_metadata*>(buf);
+             FAN_EVENT_OK(meta, len); meta = FAN_EVENT_NEXT(meta, len)) {
+            if (meta->vers != FANOTIFY_METADATA_VERSION) continue;
+            if (meta->mask & FAN_Q_OVERFLOW) { markOverflow(); continue; }
+
+            const char* p   = reinterpret_cast<const char*>(meta) + meta->metadata_len;
+            const char* end = reinterpret_cast<const char*>(meta) + meta->event_len;
+            while (p + sizeof(fanotify_event_info_header) <= end) {
+                const auto* hdr = reinterpret_cast<const fanotify_event_info_header*>(p);
+                if (hdr->len == 0) break;
+                if (hdr->info_type == FAN_EVENT_INFO_TYPE_DFID_NAME) {
+                    const auto* fid = reinterpret_cast<const fanotify_event_info_fid*>(p);
+                    const auto* fh  = reinterpret_cast<const file_handle*>(fid->handle);
+                    const char* name = reinterpret_cast<const char*>(fh->f_handle + fh->handle_bytes);
+                    const QByteArray fsid(reinterpret_cast<const char*>(&fid->fsid), qsizetype(sizeof(fid->fsid)));
+
+                    const QByteArray key = fsid + QByteArray(reinterpret_cast<const char*>(fh),
+                                                             qsizetype(sizeof(file_handle) + fh->handle_bytes));
+                    auto r = resolved.find(key);
+                    if (r == resolved.end()) {
+                        const auto mark = m_fsMarks.constFind(fsid);
+                        r = resolved.insert(key, mark == m_fsMarks.cend() ? QString() : resolveDirHandle(mark->mountFd, fh));
+                    }
+                    const QString dir = r->isEmpty() ? QString() : toRootPath(*r);
+                    if (!dir.isEmpty()) {
+                        enqueue(dir, false);
+                        if ((meta->mask & FAN_ONDIR) && (meta->mask & (FAN_CREATE | FAN_MOVED_TO)))
+                            enqueue(dir + QChar('/') + QFile::decodeName(name), true);
+                    }
+                }
+                p += hdr->len;
+            }
+        }
+    }
+#endif
+}
+
+// ========== Inotify ==========
+static const uint32_t kInoMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | IN_ATTRIB
+                               | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+
+bool RecursiveWatcher::addInotifyRoot(const QString& root) {
+    if (m_inoFd < 0) {
+        m_inoFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_inoFd < 0) return false;
+        m_inoNotifier = new QSocketNotifier(m_inoFd, QSocketNotifier::Read, this);
+        connect(m_inoNotifier, &QSocketNotifier::activated, this, [this]{ readInotify(); });
+    }
+    const int wd = watchTree(QFile::encodeName(root), -1, root);
+    if (wd < 0) return false;
+    m_rootWd.insert(root, wd);
+    return true;
+}
+
+void RecursiveWatcher::removeInotifyRoot(const QString& root) {
+    const int wd = m_rootWd.take(root);
+    if (m_nodes.contains(wd)) removeInotifySubtree(wd);
+    if (m_rootWd.isEmpty()) m_watchLimitHit = false;
+}
+
+int RecursiveWatcher::addInotifyWatch(const QByteArray& absDir, int parentWd, const QString& name) {
+    const int wd = ::inotify_add_watch(m_inoFd, absDir.constData(), kInoMask);
+    if (wd < 0) {
+        if (errno == ENOSPC && !m_watchLimitHit) { m_watchLimitHit = true; markOverflow(); } // max_user_watches
+        return -1;
+    }
+    if (m_nodes.contains(wd)) return -1; // 同一目录已在监听（嵌套根目录/绑定挂载），不再下探
+    m_nodes.insert(wd, Node{parentWd, name});
+    if (parentWd >= 0) m_children[parentWd].insert(name, wd);
+    return wd;
+}
+
+// 注册整棵目录树：readdir 按 d_type 判断子目录，只有文件系统不给类型时才 lstat
+int RecursiveWatcher::watchTree(const QByteArray& absDir, int parentWd, const QString& name) {
+    const int top = addInotifyWatch(absDir, parentWd, name);
+    if (top < 0) return -1;
+
+    QVector<QPair<int, QByteArray>> stack{{top, absDir}};
+    while (!stack.isEmpty()) {
+        const QPair<int, QByteArray> cur = stack.takeLast();
+        DIR* d = ::opendir(cur.second.constData());
+        if (!d) continue;
+        while (const dirent* e = ::readdir(d)) {
+            const char* n = e->d_name;
+            if (n[0] == '.' && (n[1] == 0 || (n[1] == '.' && n[2] == 0))) continue;
+            const QByteArray child = cur.second + '/' + n;
+            bool isDir = e->d_type == DT_DIR;
+            if (e->d_type == DT_UNKNOWN) {
+                struct stat st;
+                isDir = ::lstat(child.constData(), &st) == 0 && S_ISDIR(st.st_mode);
+            }
+            if (!isDir) continue;
+            const int wd = addInotifyWatch(child, cur.first, QFile::decodeName(n));
+            if (wd >= 0) stack.append({wd, child});
+            else if (m_watchLimitHit) { ::closedir(d); return top; }
+        }
+        ::closedir(d);
+    }
+    return top;
+}
+
+void RecursiveWatcher::removeInotifySubtree(int wd) {
+    QVector<int> todo{wd};
+    while (!todo.isEmpty()) {
+        const int w = todo.takeLast();
+        const auto c = m_children.constFind(w);
+        if (c != m_children.cend()) for (int child : *c) todo.append(child);
+        ::inotify_rm_watch(m_inoFd, w);
+        dropInotifyNode(w);
+    }
+}
+
+int RecursiveWatcher::inotifyChild(int parentWd, const QString& name) const {
+    const auto c = m_children.constFind(parentWd);
+    return c == m_children.cend() ? -1 : c->value(name, -1);
+}
+
+// 从节点表与子目录表里摘掉一个 wd（wd 会被内核复用，不能留下旧的子目录关系）
+void RecursiveWatcher::dropInotifyNode(int wd) {
+    const auto it = m_nodes.constFind(wd);
+    if (it == m_nodes.cend()) return;
+    auto p = m_children.find(it->parent);
+    if (p != m_children.end()) {
+        p->remove(it->name);
+        if (p->isEmpty()) m_children.erase(p);
+    }
+    m_children.remove(wd);
+    m_nodes.remove(wd);
+}
+
+QString RecursiveWatcher::inotifyPath(int wd) const {
+    QStringList parts;
+    for (int cur = wd; cur != -1; ) {
+        const auto it = m_nodes.constFind(cur);
+        if (it == m_nodes.cend()) return QString(); // 祖先已被移除
+        parts.prepend(it->name);
+        cur = it->parent;
+    }
+    return parts.join(QChar('/'));
+}
+
+void RecursiveWatcher::readInotify() {
+    alignas(inotify_event) char buf[64 * 1024];
+    for (;;) {
+        const ssize_t n = ::read(m_inoFd, buf, sizeof(buf));
+        if (n <= 0) break; // EAGAIN：已读空
+
+        QHash<int, QString> paths; // 同一批内每个 wd 只拼一次路径
+        for (const char* p = buf; p < buf + n; ) {
+            const auto* ev = reinterpret_cast<const inotify_event*>(p);
+            p += sizeof(inotify_event) + ev->len;
+
+            if (ev->mask & IN_Q_OVERFLOW) { markOverflow(); continue; }
+            if (ev->mask & IN_IGNORED)    { dropInotifyNode(ev->wd); continue; } // 目录已删除/卸载
+
+            auto it = paths.find(ev->wd);
+            if (it == paths.end()) it = paths.insert(ev->wd, inotifyPath(ev->wd));
+            const QString dir = *it;
+            if (dir.isEmpty()) continue;
+            enqueue(dir, false);
+
+            if (!(ev->mask & IN_ISDIR) || ev->len == 0) continue;
+            const QString name = QFile::decodeName(ev->name);
+            if (ev->mask & IN_MOVED_FROM) {
+                // 目录移走（可能移出监听范围）：撤掉整棵；若只是树内改名，随后的 IN_MOVED_TO 会重新注册
+                const int child = inotifyChild(ev->wd, name);
+                if (child >= 0) removeInotifySubtree(child);
+                paths.clear();
+            } else if (ev->mask & (IN_CREATE | IN_MOVED_TO)) {
+                const QString child = dir + QChar('/') + name;
+                watchTree(QFile::encodeName(child), ev->wd, name);
+                enqueue(child, true);
+            }
+        }
+    }
+}
+#else
+bool RecursiveWatcher::addFanotifyRoot(const QString&) { return false; }
+void RecursiveWatcher::removeFanotifyRoot(const QString&) {}
+void RecursiveWatcher::readFanotify() {}
+bool RecursiveWatcher::addInotifyRoot(const QString&) { return false; }
+void RecursiveWatcher::removeInotifyRoot(const QString&) {}
+void RecursiveWatcher::readInotify() {}
+int  RecursiveWatcher::watchTree(const QByteArray&, int, const QString&) { return -1; }
+int  RecursiveWatcher::addInotifyWatch(const QByteArray&, int, const QString&) { return -1; }
+void RecursiveWatcher::removeInotifySubtree(int) {}
+int  RecursiveWatcher::inotifyChild(int, const QString&) const { return -1; }
+void RecursiveWatcher::dropInotifyNode(int) {}
+QString RecursiveWatcher::inotifyPath(int) const { return QString(); }
+#endif
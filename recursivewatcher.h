@@ -0,0 +1,101 @@
+#pragma once
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QFileSystemWatcher;
+class QSocketNotifier;
+class QTimer;
+
+/**
+ * @brief 递归目录监听：监听若干根目录下整棵树的改动，合并后成批报告
+ * 后端按可用性逐个根目录选择（失败即退到下一种）：
+ * - Fanotify：Linux 文件系统级标记 + FAN_REPORT_DFID_NAME，每个文件系统一个标记，与目录数无关；需 CAP_SYS_ADMIN
+ * - Inotify：Linux 每目录一个 watch，直接用系统调用注册（readdir 按 d_type 找子目录，不逐项 stat），
+ *   节点只存“父 wd + 目录名”；超出 max_user_watches 时发 overflowed
+ * - Polling：其他平台，QFileSystemWatcher 逐目录
+ * 事件先进定长环形缓冲去重，节流后成批发 changed；缓冲或内核队列溢出时发 overflowed（调用方应退回全量扫描）。
+ * 根目录可单独增删（setRoots 只处理差异），不必整体重建。只在所属线程使用。
+ */
+class RecursiveWatcher : public QObject {
+    Q_OBJECT
+public:
+    enum class Backend { Fanotify, Inotify, Polling };
+
+    explicit RecursiveWatcher(QObject* parent = nullptr);
+    ~RecursiveWatcher() override;
+
+    void addRoot(const QString& path);
+    void removeRoot(const QString& path);
+    void setRoots(const QStringList& paths);       // 与当前集合求差，只增删变化的部分
+
+    QStringList roots() const { return m_roots.keys(); }
+    Backend backendFor(const QString& root) const;
+    int watchCount() const;                         // 内核侧 watch/标记数（诊断用）
+
+signals:
+    // dirs：条目或其中文件内容有变化的目录（只需重扫这一层）；trees：新出现的目录（整棵）
+    void changed(const QStringList& dirs, const QStringList& trees);
+    void overflowed();                              // 可能漏掉了事件
+
+private:
+    void enqueue(const QString& path, bool tree);
+    void markOverflow();
+    void flush();
+    QString toRootPath(const QString& canonical) const; // 内核给出的真实路径 → 用户给的根目录下的路径，不在任何根下为空
+
+    // Polling
+    void addPollingRoot(const QString& root);
+    void removePollingRoot(const QString& root);
+    void onPolledDirChanged(const QString& dir);
+
+    // Linux
+    bool addFanotifyRoot(const QString& root);
+    void removeFanotifyRoot(const QString& root);
+    void readFanotify();
+    bool addInotifyRoot(const QString& root);
+    void removeInotifyRoot(const QString& root);
+    void readInotify();
+    int  watchTree(const QByteArray& absDir, int parentWd, const QString& name); // 返回顶层 wd，失败 -1
+    int  addInotifyWatch(const QByteArray& absDir, int parentWd, const QString& name);
+    void removeInotifySubtree(int wd);
+    int  inotifyChild(int parentWd, const QString& name) const;
+    void dropInotifyNode(int wd);
+    QString inotifyPath(int wd) const;
+
+    QHash<QString, Backend> m_roots;                // 绝对路径 → 后端
+    QHash<QString, QString> m_rootCanon;            // 绝对路径 → 规范路径（经符号链接/绑定挂载到达的根与事件路径不同）
+
+    // 待发出的改动：定长环形缓冲 + 去重集合；满了即视为溢出
+    struct Pending { QString path; bool tree = false; };
+    QVector<Pending> m_ring;
+    int              m_ringHead = 0;
+    int              m_ringSize = 0;
+    QSet<QString>    m_ringKeys;
+    bool             m_overflow = false;
+    QTimer*          m_flushTimer = nullptr;
+
+    // Fanotify：每个文件系统（fsid）一个标记，多个根目录共用
+    struct FsMark { int mountFd = -1; int refs = 0; };
+    int                        m_fanFd = -1;
+    QSocketNotifier*           m_fanNotifier = nullptr;
+    QHash<QByteArray, FsMark>  m_fsMarks;
+    QHash<QString, QByteArray> m_rootFsid;
+
+    // Inotify：wd → (父 wd, 目录名)；根节点父为 -1、名字为绝对路径
+    struct Node { int parent = -1; QString name; };
+    int                  m_inoFd = -1;
+    QSocketNotifier*     m_inoNotifier = nullptr;
+    QHash<int, Node>     m_nodes;
+    QHash<int, QHash<QString, int>> m_children;     // 父 wd → 目录名 → wd（按名找子目录、撤整棵不必扫全部节点）
+    QHash<QString, int>  m_rootWd;
+    bool                 m_watchLimitHit = false;
+
+    // Polling
+    QFileSystemWatcher*  m_poller = nullptr;
+    QSet<QString>        m_polledDirs;
+};
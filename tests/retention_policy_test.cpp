@@ -0,0 +1,124 @@
+#include "RetentionPolicy.h"
+
+#include <cstdio>
+
+/**
+ * 留存策略：任一规则选中即保留
+ * - 只有天数：窗口外全部到期
+ * - 天数 + 稀疏：窗口外的旧版本仍按时/日/周档各留一份，30 天档与 52 周档要能生效
+ * - 不限天数 + 稀疏：只按档留存
+ * - 版本数上限压在所有规则之上
+ * - nextExpiryMs 只看仅靠天数窗口留下的项
+ */
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); ++g_failures; } } while (0)
+
+constexpr qint64 kHourMs = 3600LL * 1000;
+constexpr qint64 kDayMs  = 24 * kHourMs;
+constexpr qint64 kNow    = 20000 * kDayMs;                  // 某天 0 点（UTC），与周边界无关的测试都以天为单位
+
+// 同一文件每天中午一个版本，最新的一天前，共 n 天；items[i] 为 i+1 天前
+std::vector<RetentionPolicy::Item> dailyVersions(int n) {
+    std::vector<RetentionPolicy::Item> items;
+    for (int i = 0; i < n; ++i) items.push_back({0, kNow - qint64(i + 1) * kDayMs + 12 * kHourMs});
+    return items;
+}
+
+std::vector<bool> keptFlags(const RetentionPolicy& p, const std::vector<RetentionPolicy::Item>& items,
+                            qint64* next = nullptr) {
+    std::vector<bool> kept(items.size(), true);
+    for (quint32 i : p.expired(items, kNow, next)) kept[i] = false;
+    return kept;
+}
+
+int countKept(const std::vector<bool>& kept, size_t from = 0, size_t to = size_t(-1)) {
+    int n = 0;
+    for (size_t i = from; i < kept.size() && i < to; ++i) n += kept[i] ? 1 : 0;
+    return n;
+}
+
+} // namespace
+
+int main() {
+    const std::vector<RetentionPolicy::Item> items = dailyVersions(400); // 400 天，覆盖周档
+
+    // 1) 只有天数：7 天窗口（items[0..6] 在窗口内）
+    {
+        RetentionPolicy p;
+        p.days = 7;
+        qint64 next = 0;
+        const std::vector<bool> kept = keptFlags(p, items, &next);
+        CHECK(countKept(kept, 0, 7) == 7);
+        CHECK(countKept(kept, 7) == 0);
+        CHECK(next == items[6].tsMs + 7 * kDayMs);          // 窗口内最旧的一项最先到期
+    }
+
+    // 2) 天数 + 稀疏（界面的“稀疏旧版本”：24/30/52）：窗口外仍按档保留
+    {
+        RetentionPolicy p;
+        p.days = 7;
+        p.keepHourly = 24; p.keepDaily = 30; p.keepWeekly = 52;
+        qint64 next = 0;
+        const std::vector<bool> kept = keptFlags(p, items, &next);
+        CHECK(countKept(kept, 0, 7) == 7);                  // 窗口内全留
+        CHECK(countKept(kept, 7, 30) == 23);                // 日档：最近 30 个有版本的日子
+        for (size_t w = 35; w + 7 <= 300; w += 7)           // 30 天外：任意连续 7 天里恰有一份（周档）
+            CHECK(countKept(kept, w, w + 7) == 1);
+        CHECK(countKept(kept, 30) <= 52);
+        CHECK(!kept[399]);                                  // 超出 52 个周档
+        CHECK(next == std::numeric_limits<qint64>::max());  // 窗口内的项同时被日档选中：不按时间到期
+    }
+
+    // 3) 不限天数 + 稀疏：只按档留存
+    {
+        RetentionPolicy p;
+        p.days = 0;
+        p.keepDaily = 10;
+        const std::vector<bool> kept = keptFlags(p, items);
+        CHECK(countKept(kept, 0, 10) == 10);
+        CHECK(countKept(kept, 10) == 0);
+    }
+
+    // 4) 版本数上限压在稀疏之上
+    {
+        RetentionPolicy p;
+        p.days = 7;
+        p.keepDaily = 30;
+        p.keepVersions = 5;
+        const std::vector<bool> kept = keptFlags(p, items);
+        CHECK(countKept(kept) == 5);
+        CHECK(countKept(kept, 0, 5) == 5);
+    }
+
+    // 5) 分组互不影响；每组最新一项在稀疏时总是保留
+    {
+        RetentionPolicy p;
+        p.days = 1;
+        p.keepWeekly = 1;
+        std::vector<RetentionPolicy::Item> two = {{0, kNow - 200 * kDayMs}, {1, kNow - 300 * kDayMs},
+                                                  {1, kNow - 301 * kDayMs - kHourMs}};
+        const std::vector<bool> kept = keptFlags(p, two);
+        CHECK(kept[0]);
+        CHECK(kept[1]);
+    }
+
+    // 6) 没有任何规则：全部保留
+    {
+        RetentionPolicy p;
+        p.days = 0;
+        CHECK(p.isNoop());
+        CHECK(p.expired(items, kNow).empty());
+    }
+
+    if (g_failures > 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("retention_policy: ok\n");
+    return 0;
+}
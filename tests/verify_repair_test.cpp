@@ -0,0 +1,124 @@
+#include "backupworker.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+/**
+ * 写后校验的坏段修复：
+ * - 源未变、目标某段损坏 → 只重写该段，校验通过
+ * - 源在复制后被改动 → 返回 SourceChanged，目标一个字节都不动（不能写入与记录摘要都对不上的新内容）
+ * - 之后整文件重新复制即可校验通过（processFile 的处理方式）
+ */
+
+// 友元：直接调用复制/校验
+class BackupWorkerTest {
+public:
+    static void startDevice(BackupWorker& w) { w.m_device.start(); }
+    static void stopDevice(BackupWorker& w)  { w.m_device.stop(); }
+    static QString srcAbsPath(const BackupWorker& w, const QString& rel) { return w.srcAbsPath(rel); }
+    static QString dstAbsPath(const BackupWorker& w, const QString& rel) { return w.dstAbsPath(rel); }
+    static bool copyOneFile(BackupWorker& w, const QString& rel) {
+        QByteArray hash;
+        return w.copyOneFile(rel, statPath(w.srcAbsPath(rel)), statPath(w.dstAbsPath(rel)), &hash);
+    }
+    static BackupWorker::Verify verifyFile(BackupWorker& w, const QString& rel,
+                                           const QByteArray& hash, const QVector<QByteArray>& segs) {
+        return w.verifyFile(rel, hash, segs);
+    }
+    static bool isOk(BackupWorker::Verify v)            { return v == BackupWorker::Verify::Ok; }
+    static bool isSourceChanged(BackupWorker::Verify v) { return v == BackupWorker::Verify::SourceChanged; }
+};
+
+namespace {
+
+int g_failures = 0;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { QTextStream(stderr) << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed\n"; ++g_failures; } } while (0)
+
+QByteArray pattern(qint64 size) {
+    QByteArray b(size, Qt::Uninitialized);
+    quint32 x = 2463534242u;                                // xorshift：不可压缩、可复现
+    for (qint64 i = 0; i < size; ++i) { x ^= x << 13; x ^= x >> 17; x ^= x << 5; b[i] = char(x); }
+    return b;
+}
+
+bool writeFile(const QString& path, const QByteArray& data) {
+    QFile f(path);
+    return f.open(QIODevice::WriteOnly) && f.write(data) == data.size();
+}
+
+QByteArray readFile(const QString& path) {
+    QFile f(path);
+    return f.open(QIODevice::ReadOnly) ? f.readAll() : QByteArray();
+}
+
+bool patch(const QString& path, qint64 off, const QByteArray& bytes) {
+    QFile f(path);
+    return f.open(QIODevice::ReadWrite) && f.seek(off) && f.write(bytes) == bytes.size();
+}
+
+} // namespace
+
+int main() {
+    QTemporaryDir tmp;
+    CHECK(tmp.isValid());
+    const QString src = tmp.filePath("src"), dst = tmp.filePath("dst");
+    QDir().mkpath(src);
+    QDir().mkpath(dst);
+
+    const qint64 seg = TreeDigest::kSegment;
+    const QByteArray content = pattern(seg + seg / 4);      // 两段
+    const QString rel = "big.bin";
+    CHECK(writeFile(QDir(src).absoluteFilePath(rel), content));
+
+    BackupWorker::Options o;
+    o.srcDir = src;
+    o.dstDir = dst;
+    o.keepVersionsOnChange = false;
+    BackupWorker w(o);
+    BackupWorkerTest::startDevice(w);
+    const QString srcPath = BackupWorkerTest::srcAbsPath(w, rel);
+    const QString dstPath = BackupWorkerTest::dstAbsPath(w, rel);
+
+    // 期望摘要按原始内容算（与复制走 reflink/io_uring/缓冲哪条路无关）
+    TreeDigest td(o.hashAlgo);
+    td.addData(content.constData(), content.size());
+    const QByteArray hash = td.result();
+    const QVector<QByteArray> segs = td.segments();
+    CHECK(segs.size() == 2);
+
+    CHECK(BackupWorkerTest::copyOneFile(w, rel));
+    CHECK(readFile(dstPath) == content);
+
+    // 1) 源未变、目标第二段损坏：修复该段
+    CHECK(patch(dstPath, seg + 100, "XXXX"));
+    CHECK(BackupWorkerTest::isOk(BackupWorkerTest::verifyFile(w, rel, hash, segs)));
+    CHECK(readFile(dstPath) == content);
+
+    // 2) 目标第二段损坏，且源在复制后被改动：不修复、不改写目标
+    CHECK(patch(dstPath, seg + 100, "XXXX"));
+    const QByteArray damaged = readFile(dstPath);
+    CHECK(patch(srcPath, seg + 200, "YYYY"));
+    CHECK(BackupWorkerTest::isSourceChanged(BackupWorkerTest::verifyFile(w, rel, hash, segs)));
+    CHECK(readFile(dstPath) == damaged);
+
+    // 3) 按新内容整文件重来后校验通过
+    const QByteArray changed = readFile(srcPath);
+    TreeDigest td2(o.hashAlgo);
+    td2.addData(changed.constData(), changed.size());
+    const QByteArray hash2 = td2.result();
+    CHECK(BackupWorkerTest::copyOneFile(w, rel));
+    CHECK(BackupWorkerTest::isOk(BackupWorkerTest::verifyFile(w, rel, hash2, td2.segments())));
+    CHECK(readFile(dstPath) == changed);
+
+    BackupWorkerTest::stopDevice(w);
+    if (g_failures > 0) {
+        QTextStream(stderr) << g_failures << " check(s) failed\n";
+        return 1;
+    }
+    QTextStream(stdout) << "verify_repair: ok\n";
+    return 0;
+}
@@ -0,0 +1,265 @@
+#include "treewalker.h"
+#include "BoundedQueue.h"
+
+#include <QAtomicInt>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+
+#include <cerrno>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#ifdef Q_OS_LINUX
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr int    kBatch      = 512;          // 每批交回调用线程的文件数
+constexpr int    kOutBatches = 64;           // 调用线程来不及处理时最多积压的批数
+constexpr size_t kDentsBuf   = 256 * 1024;   // getdents64 一次读入的目录项字节数
+
+using FileSink = std::function<bool(TreeWalker::Entry&&)>; // 返回 false 中止
+using DirSink  = std::function<void(QString&&)>;
+
+#ifdef Q_OS_LINUX
+struct LinuxDirent64 {
+    quint64        d_ino;
+    qint64         d_off;
+    unsigned short d_reclen;
+    unsigned char  d_type;
+    char           d_name[1];
+};
+
+// 每个线程一个：持有自己的 getdents64 缓冲，目录都相对共享的根 fd 打开
+class DirLister {
+public:
+    DirLister(int rootFd, bool includeHidden)
+        : m_rootFd(rootFd), m_hidden(includeHidden), m_buf(new char[kDentsBuf]) {}
+
+    // 列出 rel 这一层：普通文件交给 onFile（带 stat），子目录交给 onDir；返回 false 表示被 onFile 中止
+    // 读不了的目录/文件计入 errors()（已消失的不算）
+    bool list(const QString& rel, const FileSink& onFile, const DirSink& onDir) {
+        const int fd = rel.isEmpty()
+            ? ::openat(m_rootFd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC)
+            : ::openat(m_rootFd, QFile::encodeName(rel).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC | O_NOFOLLOW);
+        if (fd < 0) { noteError(errno); return true; }
+        const QString prefix = rel.isEmpty() ? QString() : rel + QChar('/');
+
+        bool ok = true;
+        long n = 0;
+        while (ok && (n = ::syscall(SYS_getdents64, fd, m_buf.get(), kDentsBuf)) > 0) {
+            for (long off = 0; off < n; ) {
+                const auto* d = reinterpret_cast<const LinuxDirent64*>(m_buf.get() + off);
+                off += d->d_reclen;
+                const char* name = d->d_name;
+                if (name[0] == '.' && (!m_hidden || name[1] == 0 || (name[1] == '.' && name[2] == 0))) continue;
+
+                unsigned char type = d->d_type;
+                struct stat st;
+                bool haveStat = false;
+                if (type == DT_UNKNOWN) { // 部分文件系统不填 d_type
+                    if (::fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) { noteError(errno); continue; }
+                    haveStat = true;
+                    type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN;
+                }
+                if (type == DT_DIR) { onDir(prefix + QFile::decodeName(name)); continue; }
+                if (type != DT_REG) continue; // 符号链接/设备/管道等
+                if (!haveStat && ::fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) { noteError(errno); continue; }
+                if (!S_ISREG(st.st_mode)) continue; // 列举与 stat 之间被替换
+
+                TreeWalker::Entry e;
+                e.rel        = prefix + QFile::decodeName(name);
+                e.st.exists  = true;
+                e.st.isFile  = true;
+                e.st.size    = qint64(st.st_size);
+                e.st.mtimeMs = qint64(st.st_mtim.tv_sec) * 1000 + st.st_mtim.tv_nsec / 1000000;
+                e.st.fileId  = quint64(st.st_ino);
+                if (!onFile(std::move(e))) { ok = false; break; }
+            }
+        }
+        if (n < 0) noteError(errno);                    // 读到一半出错：这一层不完整
+        ::close(fd);
+        return ok;
+    }
+
+    int errors() const { return m_errors; }
+
+private:
+    void noteError(int err) { if (err != ENOENT && err != ENOTDIR) ++m_errors; } // 列举后被删/被替换不算
+
+    int                     m_rootFd;
+    bool                    m_hidden;
+    std::unique_ptr<char[]> m_buf;
+    int                     m_errors = 0;
+};
+#else
+class DirLister {
+public:
+    DirLister(QString root, bool includeHidden) : m_root(std::move(root)), m_hidden(includeHidden) {}
+
+    bool list(const QString& rel, const FileSink& onFile, const DirSink& onDir) {
+        const QString prefix = rel.isEmpty() ? QString() : rel + QChar('/');
+        QDir::Filters f = QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks;
+        if (m_hidden) f |= QDir::Hidden;
+        const QDir dir(m_root + QChar('/') + rel);
+        if (!dir.exists()) return true;                 // 已消失
+        if (!dir.isReadable()) { ++m_errors; return true; }
+        const QFileInfoList infos = dir.entryInfoList(f, QDir::NoSort);
+        for (const QFileInfo& fi : infos) {
+            if (fi.isDir()) { onDir(prefix + fi.fileName()); continue; }
+            TreeWalker::Entry e;
+            e.rel        = prefix + fi.fileName();
+            e.st.exists  = true;
+            e.st.isFile  = true;
+            e.st.size    = fi.size();
+            e.st.mtimeMs = fi.lastModified().toMSecsSinceEpoch();
+            if (!onFile(std::move(e))) return false;
+        }
+        return true;
+    }
+
+    int errors() const { return m_errors; }
+
+private:
+    QString m_root;
+    bool    m_hidden;
+    int     m_errors = 0;
+};
+#endif
+
+// 待列举目录：每个线程一条双端队列。自己从尾部取（深度优先，路径前缀在 dcache 里），
+// 空闲时从别人头部窃取（靠近根的目录，分到的子树更大）
+class DirQueues {
+public:
+    explicit DirQueues(int n) {
+        for (int i = 0; i < n; ++i) m_lanes.emplace_back(new Lane);
+    }
+
+    void push(int self, QString&& rel) {
+        m_pending.ref();
+        Lane& l = *m_lanes[size_t(self)];
+        QMutexLocker lk(&l.mutex);
+        l.dirs.push_back(std::move(rel));
+    }
+
+    bool take(int self, QString* out) {
+        const int n = int(m_lanes.size());
+        for (int k = 0; k < n; ++k) {
+            Lane& l = *m_lanes[size_t((self + k) % n)];
+            QMutexLocker lk(&l.mutex);
+            if (l.dirs.empty()) continue;
+            if (k == 0) { *out = std::move(l.dirs.back());  l.dirs.pop_back(); }
+            else        { *out = std::move(l.dirs.front()); l.dirs.pop_front(); }
+            return true;
+        }
+        return false;
+    }
+
+    void finish()        { m_pending.deref(); }                  // 取出的目录已列举完（子目录已入队）
+    bool drained() const { return m_pending.loadAcquire() == 0; }
+
+private:
+    struct Lane { QMutex mutex; std::deque<QString> dirs; };
+    std::vector<std::unique_ptr<Lane>> m_lanes;
+    QAtomicInt m_pending{0};                                     // 已入队、尚未列举完的目录数
+};
+
+} // namespace
+
+bool TreeWalker::walk(const QString& root, const Options& opt, const std::function<bool(Entry&)>& visit) {
+    auto cancelled = [&]{ return opt.cancelled && opt.cancelled(); };
+
+#ifdef Q_OS_LINUX
+    const int rootFd = ::open(QFile::encodeName(root).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (rootFd < 0) return (errno == ENOENT || errno == ENOTDIR) && !cancelled(); // 不存在 = 空；读不了 = 不完整
+    struct FdCloser { int fd; ~FdCloser() { ::close(fd); } } closer{rootFd};
+    auto makeLister = [&]{ return DirLister(rootFd, opt.includeHidden); };
+#else
+    if (!QFileInfo(root).isDir()) return !cancelled();
+    const QString absRoot = QDir(root).absolutePath();
+    auto makeLister = [&]{ return DirLister(absRoot, opt.includeHidden); };
+#endif
+
+    const int threads = opt.threads > 0 ? opt.threads : qBound(1, QThread::idealThreadCount(), 8);
+
+    // 单层或单线程：就在调用线程里做，不起线程
+    if (!opt.recursive || threads == 1) {
+        DirLister lister = makeLister();
+        std::vector<QString> stack{QString()};
+        while (!stack.empty()) {
+            if (cancelled()) return false;
+            const QString rel = std::move(stack.back());
+            stack.pop_back();
+            const bool ok = lister.list(rel, [&](Entry&& e){ return visit(e); },
+                                        [&](QString&& d){ if (opt.recursive) stack.push_back(std::move(d)); });
+            if (!ok) return false;
+        }
+        return lister.errors() == 0 && !cancelled();
+    }
+
+    DirQueues queues(threads);
+    queues.push(0, QString());
+    BoundedQueue<QVector<Entry>> out(kOutBatches);
+    QAtomicInt stop{0}, live{threads}, errors{0};
+    auto stopped = [&]{ return stop.loadAcquire() != 0 || cancelled(); };
+
+    auto worker = [&](int self) {
+        DirLister lister = makeLister();
+        QVector<Entry> batch;
+        auto flush = [&]{
+            if (batch.isEmpty()) return;
+            if (!out.push(std::move(batch), stopped)) stop.storeRelease(1);
+            batch = QVector<Entry>();
+        };
+        QString rel;
+        for (int idle = 0; !stopped(); ) {
+            if (queues.take(self, &rel)) {
+                idle = 0;
+                lister.list(rel,
+                            [&](Entry&& e){
+                                batch.push_back(std::move(e));
+                                if (batch.size() >= kBatch) flush();
+                                return !stopped();
+                            },
+                            [&](QString&& d){ queues.push(self, std::move(d)); });
+                queues.finish();
+                continue;
+            }
+            if (queues.drained()) break;
+            flush(); // 暂时没活：先把零头交出去
+            if (++idle < 64) QThread::yieldCurrentThread();
+            else             QThread::usleep(200);
+        }
+        flush();
+        errors.fetchAndAddRelaxed(lister.errors());
+        if (!live.deref()) out.close(); // 最后一个退出的线程收口
+    };
+
+    QVector<QThread*> pool;
+    for (int i = 0; i < threads; ++i) {
+        QThread* t = QThread::create([&worker, i]{ worker(i); });
+        t->setObjectName(QStringLiteral("TreeWalk:%1").arg(i));
+        pool.push_back(t);
+        t->start();
+    }
+
+    bool aborted = false;
+    QVector<Entry> batch;
+    while (!aborted && out.pop(&batch, cancelled)) {
+        for (Entry& e : batch)
+            if (!visit(e)) { aborted = true; break; }
+    }
+    stop.storeRelease(1); // 正常结束时各线程早已退出；中止时让它们尽快收手
+    for (QThread* t : pool) { t->wait(); delete t; }
+    return !aborted && !cancelled() && errors.loadAcquire() == 0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <QString>
+#include <functional>
+
+#include "FileStat.h"
+
+/**
+ * @brief 并行目录遍历（扫描源、删除比对、留存清理、界面列举共用）
+ * - 多线程按目录分工：每个线程一条双端队列，自己从尾部取、空闲时从别人头部窃取
+ * - Linux：每个目录 openat(根 fd, 相对路径) 后用 getdents64 大批量读目录项，靠 d_type 区分文件/目录，
+ *   只对普通文件做一次相对目录 fd 的 fstatat（文件系统不给 d_type 时才多 stat 一次目录项）
+ * - 其他平台：每个目录用 QDir 列举一层，同样并行
+ * 只返回普通文件；不跟随符号链接；默认与 QDirIterator 一致跳过隐藏项（Unix 上以 '.' 开头）。
+ * 结果按批交回调用线程串行回调，顺序不定。
+ * 遍历期间消失的目录/文件（ENOENT）直接跳过；读不了的目录（EACCES、EIO 等）也跳过、其余照常遍历，
+ * 但结果记为不完整：调用方不能据此判定“没有列出的文件已被删除”。
+ */
+class TreeWalker {
+public:
+    struct Entry {
+        QString  rel;          // 相对遍历根，'/' 分隔
+        FileStat st;           // 遍历时顺带取得，不必再 stat
+    };
+
+    struct Options {
+        bool recursive     = true;
+        bool includeHidden = false;
+        int  threads       = 0;                 // 0 = 自动（CPU 数，最多 8）
+        std::function<bool()> cancelled;        // 为真即中止（各线程都会检查）
+    };
+
+    // visit 返回 false 或 cancelled() 为真即中止并返回 false；有目录读不了时遍历完其余部分后返回 false
+    // 根不存在视为空目录（返回 true）
+    static bool walk(const QString& root, const Options& opt, const std::function<bool(Entry&)>& visit);
+};
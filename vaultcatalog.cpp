@@ -0,0 +1,274 @@
+#include "vaultcatalog.h"
+#include "chunkstore.h"
+#include "treewalker.h"
+
+#include <QAtomicInt>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QSet>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+const char    kMagic[8]  = {'P', 'B', 'C', 'A', 'T', '1', 0, 0};
+const int     kHeadBytes = 4 + 1 + 1 + 1 + 1 + 8 + 8 + 2 + 2; // len op kind algo hashLen ts size relLen payloadLen
+
+enum Op : quint8 { OpAdd = 1, OpRemove = 2, OpSrcRoot = 3 };
+
+struct AddRef { qint64 off; QString srcRoot; };             // 扫描第一遍：新增记录的位置与其源根
+
+// 记录：quint32 总长 | op | kind | algo | hashLen | qint64 ts | qint64 size | quint16 relLen | quint16 payloadLen | hash | rel | payload
+// 移除记录只用 payload；源根记录只用 rel。整数一律小端。
+QByteArray encode(Op op, quint8 kind, quint8 algo, qint64 ts, qint64 size,
+                  const QByteArray& hash, const QByteArray& rel, const QByteArray& payload) {
+    const int len = kHeadBytes + hash.size() + rel.size() + payload.size();
+    QByteArray r(len, Qt::Uninitialized);
+    uchar* p = reinterpret_cast<uchar*>(r.data());
+    qToLittleEndian<quint32>(quint32(len), p);      p += 4;
+    *p++ = op; *p++ = kind; *p++ = algo; *p++ = quint8(hash.size());
+    qToLittleEndian<qint64>(ts, p);                 p += 8;
+    qToLittleEndian<qint64>(size, p);               p += 8;
+    qToLittleEndian<quint16>(quint16(rel.size()), p);     p += 2;
+    qToLittleEndian<quint16>(quint16(payload.size()), p); p += 2;
+    memcpy(p, hash.constData(), size_t(hash.size()));       p += hash.size();
+    memcpy(p, rel.constData(), size_t(rel.size()));         p += rel.size();
+    memcpy(p, payload.constData(), size_t(payload.size()));
+    return r;
+}
+
+} // namespace
+
+VaultCatalog::VaultCatalog(QString metaRoot, QString ns)
+    : m_metaRoot(std::move(metaRoot)), m_ns(std::move(ns)), m_path(catalogPath(m_metaRoot, m_ns)) {}
+
+VaultCatalog::~VaultCatalog() { close(); }
+
+QString VaultCatalog::catalogPath(const QString& metaRoot, const QString& ns) {
+    return QDir(metaRoot).absoluteFilePath("index/" + ns + "/vault.cat");
+}
+
+qint64 VaultCatalog::tsToMs(const QString& ts) {
+    QDateTime t = QDateTime::fromString(ts, "yyyyMMdd-HHmmss");
+    t.setTimeSpec(Qt::UTC);
+    return t.isValid() ? t.toMSecsSinceEpoch() : 0;
+}
+
+bool VaultCatalog::exists() const {
+    return !m_path.isEmpty() && QFileInfo::exists(m_path);
+}
+
+bool VaultCatalog::isStale() const {
+    return !m_path.isEmpty() && QFileInfo::exists(stalePath());
+}
+
+// 目录每次追加都晚于对应边车写入，边车比目录新即有归档没记进来；找到一个即停
+bool VaultCatalog::hasNewerSidecar() const {
+    const FileStat cat = statPath(m_path);
+    if (!cat.exists) return false;
+    QAtomicInt newer{0};
+    TreeWalker::Options wo;
+    wo.cancelled = [&]{ return newer.loadRelaxed() != 0; };
+    for (const char* sub : {"versions", "deleted"}) {
+        const QString base = QDir(m_metaRoot).absoluteFilePath(QString::fromLatin1(sub) + "/" + m_ns);
+        TreeWalker::walk(base, wo, [&](TreeWalker::Entry& w) {
+            if (!w.rel.endsWith(".json", Qt::CaseInsensitive) || w.st.mtimeMs <= cat.mtimeMs) return true;
+            newer.storeRelaxed(1);
+            return false;
+        });
+        if (newer.loadRelaxed()) return true;
+    }
+    return false;
+}
+
+void VaultCatalog::beginArchive() {
+    if (m_path.isEmpty()) return;
+    QMutexLocker lk(&m_mutex);
+    if (m_archiving) return;
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+    QFile marker(stalePath());
+    if (!marker.exists()) marker.open(QIODevice::WriteOnly); // 立不起来说明目标已写不进去，归档本身也会失败
+    m_archiving = true;
+}
+
+QString VaultCatalog::relToMeta(const QString& absPath) const {
+    return QDir(m_metaRoot).relativeFilePath(absPath);
+}
+
+QByteArray VaultCatalog::encodeAdd(const Entry& e) const {
+    return encode(OpAdd, quint8(e.kind), quint8(e.algo), e.tsMs, e.size,
+                  e.hash.left(255), e.rel.toUtf8(), relToMeta(e.payload).toUtf8());
+}
+
+// 调用方持锁
+bool VaultCatalog::appendRecord(const QByteArray& rec) {
+    if (!m_file.isOpen()) {
+        QDir().mkpath(QFileInfo(m_path).absolutePath());
+        m_file.setFileName(m_path);
+        // 无缓冲：每条记录一次 write()，不会与其他写者交错出半条
+        if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Unbuffered)) return false;
+        if (m_file.size() == 0 && m_file.write(kMagic, sizeof(kMagic)) != qint64(sizeof(kMagic))) return false;
+        m_lastSrcRoot.clear();
+    }
+    return m_file.write(rec) == rec.size();
+}
+
+bool VaultCatalog::add(const Entry& e) {
+    if (m_path.isEmpty()) return false;
+    QMutexLocker lk(&m_mutex);
+    if (m_lastSrcRoot != e.srcRoot || !m_file.isOpen()) {
+        if (!appendRecord(encode(OpSrcRoot, 0, 0, 0, 0, {}, e.srcRoot.toUtf8(), {}))) { m_addFailed = true; return false; }
+        m_lastSrcRoot = e.srcRoot;
+    }
+    if (appendRecord(encodeAdd(e))) return true;
+    m_addFailed = true;
+    return false;
+}
+
+bool VaultCatalog::remove(const QString& payload) {
+    if (m_path.isEmpty()) return false;
+    QMutexLocker lk(&m_mutex);
+    return appendRecord(encode(OpRemove, 0, 0, 0, 0, {}, {}, relToMeta(payload).toUtf8()));
+}
+
+void VaultCatalog::close() {
+    QMutexLocker lk(&m_mutex);
+    if (m_file.isOpen()) m_file.close();
+    if (m_archiving && !m_addFailed) QFile::remove(stalePath()); // 本次的归档都已记上
+    m_archiving = m_addFailed = false;
+}
+
+bool VaultCatalog::scan(const std::function<void(const Entry&)>& visit, Stats* stats) const {
+    QFile f(m_path);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    const qint64 total = f.size();
+    if (total < qint64(sizeof(kMagic))) return total == 0;
+    const uchar* base = f.map(0, total);
+    QByteArray whole;
+    if (!base) { whole = f.readAll(); base = reinterpret_cast<const uchar*>(whole.constData()); } // 不支持映射的文件系统
+    if (memcmp(base, kMagic, sizeof(kMagic)) != 0) return false;
+
+    const QDir meta(m_metaRoot);
+    QVector<AddRef> adds;
+    QSet<QByteArray> removed;                              // 归档文件（相对元数据根）
+    QString srcRoot;
+
+    // 第一遍：收集新增位置与被移除的归档；第二遍只解码有效项
+    qint64 off = sizeof(kMagic);
+    while (off + kHeadBytes <= total) {
+        const uchar* p = base + off;
+        const quint32 len = qFromLittleEndian<quint32>(p);
+        if (len < quint32(kHeadBytes) || off + len > total) break; // 半条记录（写入时崩溃）
+        const int hashLen    = p[7];
+        const int relLen     = qFromLittleEndian<quint16>(p + 24);
+        const int payloadLen = qFromLittleEndian<quint16>(p + 26);
+        if (kHeadBytes + hashLen + relLen + payloadLen != int(len)) break;
+        const char* rel     = reinterpret_cast<const char*>(p + kHeadBytes + hashLen);
+        const char* payload = rel + relLen;
+        switch (p[4]) {
+        case OpSrcRoot: srcRoot = QString::fromUtf8(rel, relLen); break;
+        case OpAdd:     adds.append({off, srcRoot}); break;
+        case OpRemove:  removed.insert(QByteArray(payload, payloadLen)); break;
+        default: break;
+        }
+        off += len;
+    }
+
+    Stats st;
+    for (const AddRef& r : std::as_const(adds)) {
+        const uchar* p = base + r.off;
+        const int hashLen    = p[7];
+        const int relLen     = qFromLittleEndian<quint16>(p + 24);
+        const int payloadLen = qFromLittleEndian<quint16>(p + 26);
+        const char* hash    = reinterpret_cast<const char*>(p + kHeadBytes);
+        const char* rel     = hash + hashLen;
+        const char* payload = rel + relLen;
+        const QByteArray payloadKey = QByteArray::fromRawData(payload, payloadLen);
+        if (removed.contains(payloadKey)) { ++st.removed; continue; }
+
+        Entry e;
+        e.kind    = Kind(p[5]);
+        e.algo    = Digest::Algo(p[6]);
+        e.tsMs    = qFromLittleEndian<qint64>(p + 8);
+        e.size    = qFromLittleEndian<qint64>(p + 16);
+        e.hash    = QByteArray(hash, hashLen);
+        e.rel     = QString::fromUtf8(rel, relLen);
+        e.payload = meta.absoluteFilePath(QString::fromUtf8(payload, payloadLen));
+        e.srcRoot = r.srcRoot;
+        ++st.live;
+        visit(e);
+    }
+    st.removed += removed.size();
+    if (stats) *stats = st;
+    return true;
+}
+
+bool VaultCatalog::compact() {
+    QVector<Entry> live;
+    if (!scan([&](const Entry& e){ live.append(e); })) return false;
+
+    return rewrite(live);
+}
+
+bool VaultCatalog::rebuild() {
+    QVector<Entry> found;
+    auto collect = [&](const QString& sub, Kind kind) {
+        const QString base = QDir(m_metaRoot).absoluteFilePath(sub + "/" + m_ns);
+        TreeWalker::walk(base, {}, [&](TreeWalker::Entry& w) {
+            if (!w.rel.endsWith(".json", Qt::CaseInsensitive)) return true;
+            QFile jf(base + QChar('/') + w.rel);
+            if (!jf.open(QIODevice::ReadOnly)) return true;
+            const QJsonObject o = QJsonDocument::fromJson(jf.readAll()).object();
+            Entry e;
+            e.kind    = kind;
+            e.tsMs    = tsToMs(o.value("ts").toString());
+            e.rel     = o.value("rel").toString();
+            e.srcRoot = QDir::cleanPath(o.value("srcRoot").toString());
+            e.payload = base + QChar('/') + w.rel.chopped(5);
+            Digest::Algo algo = Digest::Algo::Sha256;
+            if (Digest::fromName(o.value("hashAlgo").toString(), &algo)) e.algo = algo;
+            e.hash    = QByteArray::fromHex(o.value("hash").toString().toLatin1());
+            const QFileInfo pf(e.payload);
+            if (e.rel.isEmpty() || !pf.exists()) return true;   // 归档已不在
+            e.size = ChunkStore::isManifest(e.payload) ? 0 : pf.size();
+            found.append(e);
+            return true;
+        });
+    };
+    collect("versions", Kind::Version);
+    collect("deleted",  Kind::Deleted);
+    std::sort(found.begin(), found.end(), [](const Entry& a, const Entry& b){ return a.tsMs < b.tsMs; });
+
+    if (!rewrite(found)) return false;
+    QMutexLocker lk(&m_mutex);
+    if (!m_archiving) QFile::remove(stalePath());           // 本次已在归档：标记留给 close() 判断
+    return true;
+}
+
+// 整体重写（QSaveFile：写临时文件后改名，正在映射旧文件的读者不受影响）
+bool VaultCatalog::rewrite(const QVector<Entry>& entries) {
+    QMutexLocker lk(&m_mutex);
+    if (m_file.isOpen()) m_file.close();                    // 之后的追加打开新文件
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+    QSaveFile f(m_path);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    f.write(kMagic, sizeof(kMagic));
+    QString root;
+    bool first = true;
+    for (const Entry& e : entries) {
+        if (first || e.srcRoot != root) {
+            f.write(encode(OpSrcRoot, 0, 0, 0, 0, {}, e.srcRoot.toUtf8(), {}));
+            root = e.srcRoot;
+            first = false;
+        }
+        f.write(encodeAdd(e));
+    }
+    return f.commit();
+}
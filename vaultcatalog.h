@@ -0,0 +1,82 @@
+#pragma once
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+#include "digest.h"
+
+/**
+ * @brief 留存区目录（每个命名空间一份）：dst/.plugbackup_meta/index/<ns>/vault.cat
+ * 追加式二进制记录：新增（版本/删除项归档时）、移除（留存清理删掉归档时）、源根（其后新增项的 srcRoot）。
+ * 列举/搜索留存区只需顺序读这一个文件（内存映射），不再遍历 versions/、deleted/ 并逐个解析 .json。
+ * - 每条记录一次 write() 追加；崩溃留下的半条记录在读取时忽略
+ * - 移除记录过多时 compact() 重写为只含有效项（写临时文件后改名，读者不受影响）
+ * - 没有目录的旧留存区由 rebuild() 从 .json 边车文件生成一次
+ * - 归档前 beginArchive() 立“未记全”标记（vault.cat.stale），本次的新增全部写进去才在 close() 时撤掉；
+ *   写失败、归档后拔盘/崩溃都会留下标记，下次由 rebuild() 重建，留存清理不会漏掉没记上的归档
+ * .json 边车照常写入（外部工具/旧版本可读），目录是它们的索引。
+ */
+class VaultCatalog {
+public:
+    enum class Kind : quint8 { Version = 0, Deleted = 1 };
+
+    struct Entry {
+        Kind         kind   = Kind::Version;
+        qint64       tsMs   = 0;                            // 归档时间（UTC）
+        qint64       size   = 0;                            // 原文件大小
+        Digest::Algo algo   = Digest::Algo::Sha256;
+        QByteArray   hash;                                  // 原文件摘要（已知时）
+        QString      rel;                                   // 相对源根
+        QString      payload;                               // 归档文件绝对路径（整文件或 .pbm 清单）
+        QString      srcRoot;
+
+        QString origAbs() const { return srcRoot + QChar('/') + rel; }
+        QString metaPath() const { return payload + ".json"; }
+    };
+
+    struct Stats { int live = 0; int removed = 0; };
+
+    VaultCatalog() = default;
+    VaultCatalog(QString metaRoot, QString ns);
+    ~VaultCatalog();
+    VaultCatalog(const VaultCatalog&) = delete;
+    VaultCatalog& operator=(const VaultCatalog&) = delete;
+
+    QString path() const { return m_path; }
+    bool exists() const;
+    bool isStale() const;                                   // 有归档可能没记进目录，应 rebuild()
+    bool hasNewerSidecar() const;                           // 有比目录新的 .json 边车（如旧版程序写入的归档）
+
+    // 写（所属任务的多个复制通道可并发调用）
+    void beginArchive();                                    // 移入留存区之前调用（幂等）
+    bool add(const Entry& e);                               // 失败时“未记全”标记保留
+    bool remove(const QString& payload);
+    void close();                                           // 任务结束时释放文件
+
+    // 读：按追加顺序回调有效项；文件不存在返回 false
+    bool scan(const std::function<void(const Entry&)>& visit, Stats* stats = nullptr) const;
+    bool compact();                                         // 只保留有效项
+    bool rebuild();                                         // 从 versions/<ns>、deleted/<ns> 下的 .json 生成；成功后撤掉标记
+
+    static QString catalogPath(const QString& metaRoot, const QString& ns);
+    static qint64  tsToMs(const QString& ts);               // "yyyyMMdd-HHmmss"（UTC）
+
+private:
+    bool appendRecord(const QByteArray& rec);
+    bool rewrite(const QVector<Entry>& entries);
+    QByteArray encodeAdd(const Entry& e) const;
+    QString relToMeta(const QString& absPath) const;
+    QString stalePath() const { return m_path + ".stale"; }
+
+    QString m_metaRoot;
+    QString m_ns;
+    QString m_path;
+    QMutex  m_mutex;
+    QFile   m_file;
+    QString m_lastSrcRoot;                                  // 本次写入已记录的源根
+    bool    m_archiving = false;                            // 本次已立“未记全”标记
+    bool    m_addFailed = false;                            // 本次有新增没写进去：标记留到下次重建
+};